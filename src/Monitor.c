@@ -4,7 +4,6 @@
 #include <string.h>
 #include <errno.h>
 #include <dirent.h>
-#include <time.h>
 #include <sys/types.h>
 #include <signal.h>
 #include <sys/stat.h>
@@ -30,7 +29,6 @@ int main(int argc, char const *argv[])
 		exit(EXIT_FAILURE);
 	}
 
-	srand((unsigned int)time(NULL));
 	const char * fifo_read_path = argv[1]; 		/* argv[1] is fifo path for read (parent writes) */
 	const char * fifo_write_path = argv[2];		/* argv[2] is fifo path for write (parent reads) */
 
@@ -50,14 +48,21 @@ int main(int argc, char const *argv[])
 	}
 
 	/* initialization phase (part2) */		
-	int bufferSize;	unsigned int bloom_size;	
-	if (read_buffer_bloom_size(&bufferSize, &bloom_size, read_fd, write_fd) < 0)	// read bufferSize and bloom_size from travelMonitor
+	int bufferSize;	unsigned int bloom_size, options, hashes, threads;
+	if (read_buffer_bloom_size(&bufferSize, &bloom_size, &options, &hashes, &threads, read_fd, write_fd) < 0)	// read bufferSize, bloom_size, options, hashes and threads from travelMonitor
 		exit(EXIT_FAILURE);
 
 	/* initialization phase (part3) */
-	struct Monitor * monitor = Monitor_init(bufferSize, bloom_size, 8, 0.5); 	// initialize structures kept by Monitor
+	struct Monitor * monitor = Monitor_init(bufferSize, bloom_size, options, hashes, threads); 	// initialize structures kept by Monitor
 	monitor->read_fd = read_fd;
 	monitor->write_fd = write_fd;
+	monitor->snapshot_path = malloc(strlen(fifo_read_path) + strlen(SNAPSHOT_SUFFIX) + 1);	// the snapshot is named after the fifo, that the replacement gets too
+	if (monitor->snapshot_path == NULL)
+	{
+		fprintf(stderr, "[Error] : Monitor -> main -> malloc\n\n");
+		exit(EXIT_FAILURE);
+	}
+	sprintf(monitor->snapshot_path, "%s%s", fifo_read_path, SNAPSHOT_SUFFIX);
 
 	/* initialization phase (final part) */
 	if (read_subdirs(monitor) < 0)
@@ -93,7 +98,8 @@ int main(int argc, char const *argv[])
 			exit(EXIT_FAILURE);
 		}
 
-		if ((message = read_message(read_fd, &msgd, bufferSize)) == NULL)		// wait here until you read message or get interrupted by a signal
+		// wait here until you read message (and its request id, that is echoed back in the reply) or get interrupted by a signal
+		if ((message = read_message_id(read_fd, &msgd, &monitor->req_id, bufferSize)) == NULL)
 			continue;	// if message returned was NULL,  that means read was safely interrupted by signal so we handle the signal first and then read the message
 
 
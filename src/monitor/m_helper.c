@@ -7,46 +7,116 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include "m_helper.h"
-#include "skip_list.h"
+#include "bptree.h"
 #include "bloom.h"
 #include "hash.h"
+#include "id_index.h"
 #include "list.h"
 #include "m_items.h"
+#include "m_ingest.h"
+#include "m_snapshot.h"
 #include "messages.h"
+#include "pool.h"
+#include "date.h"
 
-
+#define RECORD_BYTES 48					// typical size of a record in the input files, used to estimate the number of records
 
 /*===================== INITIALIZATION PHASE ===========================*/
 
-struct Monitor * Monitor_init(int bufferSize, unsigned int bloom_size, int max_level, float p)
+// creates the (empty) citizens, viruses and countries of monitor
+static void state_create(struct Monitor * monitor)
+{
+	monitor->citizens_info = id_index_create((HashKey) m_get_citizen_id, (HashDestroy) m_citizen_info_destroy);
+	monitor->citizens_arena = arena_create();
+	monitor->names = intern_create(monitor->citizens_arena);
+	monitor->viruses_info = hash_create(10, (HashKey) m_get_virus_name, (HashDestroy) m_virus_info_destroy);
+	monitor->viruses_by_id = NULL;
+	monitor->countries_info = hash_create(10, (HashKey) m_get_country_name, (HashDestroy) m_country_info_destroy);
+}
+
+// destroys the citizens, viruses and countries of monitor
+static void state_destroy(struct Monitor * monitor)
+{
+	hash_destroy(monitor->countries_info);
+	id_index_destroy(monitor->citizens_info);
+	intern_destroy(monitor->names);
+	arena_destroy(monitor->citizens_arena);		// the citizens, all at once
+	hash_destroy(monitor->viruses_info);
+	free(monitor->viruses_by_id);
+}
+
+struct Monitor * Monitor_init(int bufferSize, unsigned int bloom_size, unsigned int options, unsigned int hashes, unsigned int threads)
 {
 	struct Monitor * monitor = malloc(sizeof(struct Monitor));
 	if (monitor == NULL)
 		fprintf(stderr, "Error : Monitor_init -> malloc \n\n");
 	assert(monitor != NULL);
 
-	monitor->citizens_info = hash_create(100, 0);
-	monitor->viruses_info = hash_create(10, 1);
-	monitor->countries_info = hash_create(10, 2);
+	state_create(monitor);
 	monitor->bufferSize = bufferSize;
 	monitor->bloom_size = bloom_size;
-	monitor->max_level = max_level;
-	monitor->p = p;
+	monitor->options = options;
+	monitor->hashes = hashes;
+	monitor->threads = threads;
+	monitor->req_id = 0;
 	monitor->accepted = 0;
 	monitor->rejected = 0;
+	monitor->subdirs = NULL;
+	monitor->num_subdirs = 0;
+	monitor->snapshot_path = NULL;
 	bloomSize_init(bloom_size);		// initialize bloomSize for messages.c
 
 	return monitor;
 }
 
-int read_buffer_bloom_size(int * bufferSize, unsigned int * bloom_size, int read_fd, int write_fd)
+// sends the bloom filter of given virus to the travelMonitor, only if it changed since it was last sent
+// a shared bloom filter is sent as just its handle (MSG13), since the travelMonitor sees its bit array through the shared memory
+// a private one is sent whole (MSG2) the first time, and then as the words that changed since it was last sent (MSG14)
+// with OPTION_XOR_FILTER, a xor filter of the vaccinated citizens is built and sent instead (MSG15), whatever the bloom filter is
+static void send_bloom_filter(struct Monitor * monitor, M_VirusInfo virus_info)
+{
+	Bloom bloom = m_get_bloom_filter(virus_info);
+	if (monitor->options & OPTION_XOR_FILTER)
+	{
+		if (!m_bloom_changed(virus_info))		// the bloom filter tells if the vaccinated citizens changed
+			return;
+		XorFilter filter = m_build_xor_filter(virus_info, monitor->bloom_size);	// no more memory than a bloom filter, if possible
+		void * response_msg = create_msg15(m_get_virus_name(virus_info), filter);
+		xor_filter_destroy(filter);
+		send_message(monitor->write_fd, MSG15, response_msg, monitor->bufferSize);
+	}
+	else if (bloom->shared)
+	{
+		if (!m_bloom_changed(virus_info))
+			return;
+		void * response_msg = create_msg13(m_get_virus_name(virus_info), bloom->shm_fd, bloom->generation);	// create message
+		send_message(monitor->write_fd, MSG13, response_msg, monitor->bufferSize);		// send message
+	}
+	else if (!m_bloom_changed(virus_info))		// the travelMonitor already has this bloom filter
+		return;
+	else if (!m_bloom_was_sent(virus_info) ||
+			 MSG14_SIZE(bloom_dirty_runs(bloom), bloom->dirty_words) >= msg2_size(monitor->bloom_size, bloom))	// the whole bit array is needed, or is smaller
+	{
+		void * response_msg = create_msg2(m_get_virus_name(virus_info), monitor->bloom_size , bloom);	// create message
+		send_message(monitor->write_fd, MSG2, response_msg, monitor->bufferSize);				// send message
+	}
+	else
+	{
+		void * response_msg = create_msg14(m_get_virus_name(virus_info), bloom);		// send only the words that changed
+		send_message(monitor->write_fd, MSG14, response_msg, monitor->bufferSize);
+	}
+	m_bloom_sent(virus_info);
+}
+
+int read_buffer_bloom_size(int * bufferSize, unsigned int * bloom_size, unsigned int * options, unsigned int * hashes, unsigned int * threads, int read_fd, int write_fd)
 {
 	int msgd;
 	void * message = read_message(read_fd, &msgd, sizeof(int));		// read first message sent by travelMonitor, bufferSize is unknown so we set it to the minimum possible
 	if (msgd != MSG0)		// expected message descriptor is MSG0
 		return -1;
-	if (decode_msg0(msgd, message, bufferSize, bloom_size) < 0)		// decode message to extract bufferSize, bloom_size
+	if (decode_msg0(msgd, message, bufferSize, bloom_size, options, hashes, threads) < 0)		// decode message to extract bufferSize, bloom_size, options, hashes, threads
 		return -1;			// unexpected message descriptor
 
 	delete_message(message);		// message is no longer needed
@@ -73,31 +143,60 @@ int read_subdirs(struct Monitor * monitor)
 		char subdir[30];
 		if (decode_msg1(msgd, message, subdir) < 0)				/* decode message of expected type (MSG1 or MSG1_NO_REPLY) */
 			return -1;											// unexpected message descriptor
-		if (read_subdir(monitor, subdir) < 0)					/* read subdirectory sent by travelMonitor */
-			return -1;
+		monitor->subdirs = realloc(monitor->subdirs, (monitor->num_subdirs + 1) * sizeof(char *));	/* keep the subdirectory, to read it below */
+		if (monitor->subdirs == NULL)
+			fprintf(stderr, "Error : read_subdirs -> realloc\n");
+		assert(monitor->subdirs != NULL);
+		monitor->subdirs[monitor->num_subdirs] = malloc(strlen(subdir) + 1);
+		strcpy(monitor->subdirs[monitor->num_subdirs++], subdir);
 		delete_message(message);  								/* message is no longer needed */
 	}
 
+	// a Monitor that replaces a terminated one starts from the snapshot the old one left, so only the files not in it are read
+	// if the snapshot is corrupt, the part of it already loaded is thrown away, and every file is read as if there was no snapshot
+	if (no_reply && m_snapshot_load(monitor) < 0)
+	{
+		state_destroy(monitor);
+		state_create(monitor);
+	}
+	for (int i = 0; i < monitor->num_subdirs; ++i)
+		if (read_subdir(monitor, monitor->subdirs[i]) < 0)		/* read subdirectory sent by travelMonitor */
+			return -1;
+
 	if (no_reply)	// if parent does not expect back any bloom filters, just return DONE
 	{
 		send_message(monitor->write_fd, DONE, NULL, monitor->bufferSize);
+		m_snapshot_save(monitor);		// a failed snapshot is not fatal, a replacement would read the files instead
 		return 0;
 	}
 	
 	// travelMonitor is done assigning subdirs to you, so send him back the bloom filters
 	M_VirusInfo virus_info;
 	// iterate upon the hash-table of viruses
-	while ((virus_info = hash_iterate_next(monitor->viruses_info)) != NULL)
-	{
-		void * response_msg = create_msg2(m_get_virus_name(virus_info), monitor->bloom_size , m_get_bloom_filter(virus_info));	// create message
-		send_message(monitor->write_fd, MSG2, response_msg, monitor->bufferSize);				// send message
-	}
+	struct hash_cursor cursor;
+	hash_cursor_init(monitor->viruses_info, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+		send_bloom_filter(monitor, virus_info);
 
 	/* when you are done with sending the bloom filters, notify parent that you are done and ready for commands */
 	send_message(monitor->write_fd, DONE, NULL, monitor->bufferSize);
+	m_snapshot_save(monitor);		// a failed snapshot is not fatal, a replacement would read the files instead
 	return 0;
 }
 
+// estimates the number of records in the count files of paths, from their sizes
+static unsigned long estimate_records(char ** paths, int count)
+{
+	unsigned long bytes = 0;
+	struct stat st;
+	for (int i = 0; i < count; ++i)
+	{
+		if (stat(paths[i], &st) == 0 && S_ISREG(st.st_mode))
+			bytes += st.st_size;
+	}
+	return bytes / RECORD_BYTES;
+}
+
 int read_subdir(struct Monitor * monitor, char * subdir)
 {
 	struct dirent ** file_list;
@@ -118,168 +217,162 @@ int read_subdir(struct Monitor * monitor, char * subdir)
 		perror("[Error] : read_subdir -> scandir\n");
 		return -1;
 	}
-	else
+
+	// the files that have not been read yet, in alphabetical order
+	char ** paths = malloc(n * sizeof(char *));
+	char ** names = malloc(n * sizeof(char *));
+	if (n > 0 && (paths == NULL || names == NULL))
+		fprintf(stderr, "Error : read_subdir -> malloc\n");
+	assert(n == 0 || (paths != NULL && names != NULL));
+	int count = 0;
+	M_CountryInfo country_info = (M_CountryInfo) hash_search(monitor->countries_info, country_name);
+	for (int i = 0; i < n; ++i)
 	{
-		for (int i = 0; i < n; ++i)
+		if (strcmp(file_list[i]->d_name, ".") && strcmp(file_list[i]->d_name, "..") &&	// if you are at . or .. just ignore
+			(country_info == NULL || m_country_search_file(country_info, file_list[i]->d_name) == NULL))	// and the files already read too
 		{
-			if (!strcmp(file_list[i]->d_name, ".") || !strcmp(file_list[i]->d_name, ".."))	// if you are at . or .. just ignore
-			{
-				free(file_list[i]);
-				continue;
-			}
+			paths[count] = malloc(strlen(subdir) + strlen(file_list[i]->d_name) + 2);
+			sprintf(paths[count], "%s/%s", subdir, file_list[i]->d_name);
+			names[count++] = file_list[i]->d_name;
+		}
+	}
 
-			M_CountryInfo country_info1 = (M_CountryInfo) hash_search(monitor->countries_info, country_name);
-			if (country_info1 != NULL)	// if this country is already in countries HT
-			{
-				if (m_country_search_file(country_info1, file_list[i]->d_name) != NULL)		// and this file has already been read
-				{
-					free(file_list[i]);
-					continue;			// just ignore it and continue
-				}
-			}
-			
-			char * line = NULL;
-			char * citizenID , * firstName, * lastName, * country, * virusName, * vacc, * date;
-			int age;
-    		size_t length = 0;
-
-    		FILE *file_ptr;
-    		char file_path[40];
-    		if (snprintf(file_path, 40, "%s/%s", subdir, file_list[i]->d_name) < 0)
-    		{
-    			fprintf(stderr, "[Error] : read_subdir -> snprintf\n");
-    			return -1;
-    		}
-
-			file_ptr = fopen(file_path, "r");  /*open citizen records txt file , in read mode*/
-			if (file_ptr == NULL)
-			{
-			    fprintf(stderr, "[Error] : read_subdir -> fopen, could not open file\n");
-			    return -1;
-			}
-			else    /*following block of code reads from the file and inserts the entries of file*/
-			{
-				// check if file is empty first
-				int c = fgetc(file_ptr);	// read char from file
-				if (c == EOF) // file is empty
-				{
-					free(file_list[i]);
-					continue;		// ignore it and continue
-				}
-				ungetc(c, file_ptr);	// else undo char read
-			  	while(getline(&line, &length, file_ptr) != -1)
-			    {
-			    	date = NULL;
-			    	line[strlen(line)-1] = '\0';		// remove newline character from line read from file
-			      	char *str = strtok(line, " ");
-			      	int i = 1;
-			      	while(str != NULL)
-			      	{
-			         	switch (i)
-			         	{
-			         		case 1: citizenID = str; break;
-			         		case 2: firstName = str; break;
-			         		case 3: lastName = str; break;
-			         		case 4: country = str; break;
-			         		case 5: age = atoi(str); break;
-			         		case 6: virusName = str; break;
-			         		case 7: vacc = str; break;
-			         		case 8: date = str; break;
-			         	}
-
-			         	i++;
-			         	str = strtok(NULL, " ");
-			      	}
-			     
-			      	Monitor_insert(monitor, citizenID, firstName, lastName, country, age, virusName, vacc, date);			     
-			     }
-
-			    free(line);
-			}
+	// make room for the citizens of the files (at most one per record), so that the table of the non-numeric ids does not grow while reading
+	id_index_reserve(monitor->citizens_info, (int) estimate_records(paths, count));
+	/* read the files and insert their records, in parallel if the Monitor has threads */
+	int result = m_ingest_files(monitor, paths, count);
+
+	country_info = (M_CountryInfo) hash_search(monitor->countries_info, country_name);
+	for (int i = 0; i < count; ++i)
+	{
+		if (result == 0 && country_info != NULL)		// the country exists, unless its files had no records so far
+			m_country_add_file(country_info, names[i]);
+		free(paths[i]);
+	}
+	for (int i = 0; i < n; ++i)
+		free(file_list[i]);
+	free(file_list);
+	free(paths);
+	free(names);
+	return result;
+}
 
-			M_CountryInfo country_info = (M_CountryInfo) hash_search(monitor->countries_info, country_name);
-			m_country_add_file(country_info, file_list[i]->d_name);
 
-			fclose(file_ptr);
-			free(file_list[i]);
-		}
+// reports an invalid record (with the error found), printed, or kept by the shard that inserts it, to be printed in the order of the records
+#define RECORD_ERROR "ERROR IN RECORD : %s %s %s %s %d %s %s %s\n%s\n\n"
 
-		free(file_list);
-		return 0;	// normal return, everything went smoothly
+// removes the record of given citizen for given virus, from the vaccinated persons (and the counting bloom filter), if it was vaccinated
+// (a not vaccinated citizen is only in its own records, where the new record replaces the old one)
+static void remove_record(struct Monitor * monitor, M_Shard shard, M_VirusInfo virus_info, M_CitizenInfo citizen_info, bool vaccinated)
+{
+	if (vaccinated)
+	{
+		if (shard != NULL)
+			m_shard_bloom_remove(shard, virus_info, citizen_info);
+		else
+			bloom_remove(m_get_bloom_filter(virus_info), (unsigned char *) m_get_citizen_id(citizen_info));
+		bptree_delete(m_get_vacc_list(virus_info, m_citizen_shard(m_get_citizen_id(citizen_info), monitor->threads)), m_get_citizen_key(citizen_info));
 	}
 }
 
+M_VirusInfo Monitor_add_virus(struct Monitor * monitor, char * virusName)
+{
+	int id = hash_size(monitor->viruses_info);		// viruses are numbered in the order they are met
+	M_VirusInfo virus_info = m_virus_info_create(virusName, id, monitor->bloom_size, monitor->hashes, monitor->options, monitor->threads);
+	hash_insert(monitor->viruses_info, virus_info);
+	monitor->viruses_by_id = realloc(monitor->viruses_by_id, (id + 1) * sizeof(M_VirusInfo));
+	if (monitor->viruses_by_id == NULL)
+		fprintf(stderr, "Error : Monitor_add_virus -> realloc\n\n");
+	assert(monitor->viruses_by_id != NULL);
+	monitor->viruses_by_id[id] = virus_info;
+	return virus_info;
+}
 
-void Monitor_insert(struct Monitor * monitor, char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date)
+void Monitor_insert(struct Monitor * monitor, M_Shard shard, char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date)
 {
 
-	// search for an already existing citizen record with same ID
-	M_CitizenInfo citizen_info = (M_CitizenInfo) hash_search(monitor->citizens_info, citizenID);
+	unsigned int day = (date != NULL) ? date_parse(date) : DATE_NONE;		// the date is parsed once, and kept as a day number
+	// search for an already existing citizen record with same ID (a shard also has the ones it created)
+	M_CitizenInfo citizen_info = (shard != NULL) ? m_shard_search_citizen(shard, citizenID) : (M_CitizenInfo) id_index_search(monitor->citizens_info, citizenID);
 	// search for an already existing virus record with given name
-	M_VirusInfo virus_info = (M_VirusInfo) hash_search(monitor->viruses_info, virusName);
+	M_VirusInfo virus_info = (shard != NULL) ? m_shard_search_virus(shard, virusName) : (M_VirusInfo) hash_search(monitor->viruses_info, virusName);
 	// search for an already existing country record with given name
-	M_CountryInfo country_info = (M_CountryInfo) hash_search(monitor->countries_info, country);
+	M_CountryInfo country_info = (shard != NULL) ? m_shard_search_country(shard, country) : (M_CountryInfo) hash_search(monitor->countries_info, country);
+	char * error = NULL;
 
 	if (citizen_info != NULL)		// if a citizen record with same ID already exists
 	{
 		// check if new record is inconsistent
 		if (strcmp(firstName, m_get_citizen_name(citizen_info)) != 0 || strcmp(lastName, m_get_citizen_surname(citizen_info)) != 0 
 			|| strcmp(country, m_get_citizen_country(citizen_info)) != 0 || age != m_get_citizen_age(citizen_info))
-		{
-			printf("ERROR IN RECORD : %s %s %s %s %d %s %s ", citizenID, firstName, lastName, country, age, virusName, vacc); printf( (date == NULL) ? "\n" : "%s\n", date);
-			printf("INCONSISTENT INPUT DATA\n\n");
-			return;
-		}
+			error = "INCONSISTENT INPUT DATA";
 
-		if (virus_info != NULL)
+		else if (virus_info != NULL)
 		{
-			char * temp_date;
+			bool vaccinated;
+			unsigned int temp_date;
 			// check if new record is duplicate (same ID, but also same virus - that means, an entry with given ID already exists for given virus)
-			// if it exists it is either on the vaccinated skip list or non vaccinated skip list for given virus
-			if (skip_list_search(m_get_vacc_list(virus_info), citizenID, &temp_date) || skip_list_search(m_get_non_vacc_list(virus_info), citizenID, &temp_date))
+			// if it exists it is among the vaccination records of the citizen
+			if (m_citizen_find_record(citizen_info, m_get_virus_id(virus_info), &vaccinated, &temp_date))
 			{
-				printf("ERROR IN RECORD : %s %s %s %s %d %s %s ", citizenID, firstName, lastName, country, age, virusName, vacc); printf( (date == NULL) ? "\n" : "%s\n", date);
-				printf("INPUT DATA DUPLICATION\n\n");
-				return;
+				// with counting bloom filters, a (valid) record that changes the vaccination status of the citizen is a correction of the
+				// old record, that is removed (from the bloom filter too) and replaced by the new one
+				bool correction = (monitor->options & OPTION_COUNTING_BLOOM) && vaccinated == !strcmp(vacc, "NO") &&
+								  (!strcmp(vacc, "YES") ? day != DATE_NONE : date == NULL);
+				if (!correction)
+					error = "INPUT DATA DUPLICATION";
+				else
+					remove_record(monitor, shard, virus_info, citizen_info, vaccinated);
 			}
 		}
 	}
 
-	// at last, check for invalid data form, i.e. vaccinated == "YES" but no date is given or vaccinated = "NO" but a date is given
-	if ( ( !strcmp(vacc, "YES") && date == NULL) || (!strcmp(vacc, "NO") && date != NULL) )
+	// at last, check for invalid data form, i.e. vaccinated == "YES" but no (valid) date is given or vaccinated = "NO" but a date is given
+	if (error == NULL && ( ( !strcmp(vacc, "YES") && day == DATE_NONE) || (!strcmp(vacc, "NO") && date != NULL) ))
+		error = "INVALID INPUT DATA FORM";
+
+	if (error != NULL)
 	{
-		printf("ERROR IN RECORD : %s %s %s %s %d %s %s ", citizenID, firstName, lastName, country, age, virusName, vacc); printf( (date == NULL) ? "\n" : "%s\n", date);
-		printf("INVALID INPUT DATA FORM\n\n");
+		if (shard != NULL)
+			m_shard_error(shard, RECORD_ERROR, citizenID, firstName, lastName, country, age, virusName, vacc, (date == NULL) ? "" : date, error);
+		else
+			printf(RECORD_ERROR, citizenID, firstName, lastName, country, age, virusName, vacc, (date == NULL) ? "" : date, error);
 		return;
 	}
 
-	if (country_info == NULL)
+	if (country_info == NULL && shard != NULL)
+		country_info = m_shard_add_country(shard, country);
+	else if (country_info == NULL)
 	{
 		country_info = m_country_info_create(country);		// if given country name is new, create new country record
 		hash_insert(monitor->countries_info, country_info);			// insert it into countries index for future reference
 	}
 
-	if (citizen_info == NULL)			// given record is a new citizen record (new ID)
+	if (citizen_info == NULL && shard != NULL)
+		citizen_info = m_shard_add_citizen(shard, citizenID, firstName, lastName, age, country_info);
+	else if (citizen_info == NULL)			// given record is a new citizen record (new ID)
 	{
-		citizen_info = m_citizen_info_create(citizenID, firstName, lastName, age, country_info);	// create new citizen record
-		hash_insert(monitor->citizens_info, citizen_info);				// insert it into citizens index for future reference
+		citizen_info = m_citizen_info_create(monitor->citizens_arena, monitor->names, citizenID, id_index_key(monitor->citizens_info, citizenID), firstName, lastName, age, country_info);	// create new citizen record
+		id_index_insert(monitor->citizens_info, citizen_info);				// insert it into citizens index for future reference
 	}
 
 	if (virus_info == NULL)
-	{
-		virus_info = m_virus_info_create(virusName, monitor->bloom_size, monitor->max_level, monitor->p);
-		hash_insert(monitor->viruses_info, virus_info);
-	}
+		virus_info = (shard != NULL) ? m_shard_add_virus(shard, virusName) : Monitor_add_virus(monitor, virusName);
 
-	// insert citizen into bloom filter, correct skip list, of given virus
-	if (!strcmp(vacc, "YES"))
+	// insert a vaccinated citizen into bloom filter and tree of given virus, and record the vaccination to the citizen
+	bool vaccinated = !strcmp(vacc, "YES");
+	if (vaccinated)
 	{
-		bloom_insert(m_get_bloom_filter(virus_info), (unsigned char*) citizenID);	// bloom filter of virus, keeps track of the vaccinated citizens
-		skip_list_insert(m_get_vacc_list(virus_info), citizen_info, date);		// insert into vaccinated persons skip list if citizen was vaccinated
+		// bloom filter of virus, keeps track of the vaccinated citizens
+		if (shard != NULL)
+			m_shard_bloom_insert(shard, virus_info, citizen_info);
+		else
+			bloom_insert(m_get_bloom_filter(virus_info), (unsigned char*) citizenID);
+		// the tree is read when the xor filter is built
+		bptree_insert(m_get_vacc_list(virus_info, m_citizen_shard(citizenID, monitor->threads)), m_get_citizen_key(citizen_info), citizen_info);
 	}
-	else
-		skip_list_insert(m_get_non_vacc_list(virus_info), citizen_info, date);	// insert into not vaccinated skip list if citizen was not vaccinated
-	
+	m_citizen_set_record(citizen_info, m_get_virus_id(virus_info), vaccinated, day);
+
 }
 
 
@@ -289,7 +382,7 @@ void Monitor_insert(struct Monitor * monitor, char * citizenID , char * firstNam
 /* wrapper function that calls a specific function to take action based on message received */
 int Monitor_take_action(struct Monitor * monitor, int msgd, void * message, char * subdir)
 {
-	if (msgd != MSG1 && msgd != MSG3 && msgd != MSG5 && msgd != MSG8)		// Monitor handles message descriptors that refer to him only
+	if (msgd != MSG1 && msgd != MSG3 && msgd != MSG5 && msgd != MSG8 && msgd != MSG10 && msgd != MSG12)		// Monitor handles message descriptors that refer to him only
 		return -1;
 	if (msgd == MSG1)
 	{
@@ -324,6 +417,18 @@ int Monitor_take_action(struct Monitor * monitor, int msgd, void * message, char
 		else
 			monitor->rejected += 1;
 
+		send_message_id(monitor->write_fd, DONE, monitor->req_id, NULL, monitor->bufferSize);	// notify parent you are done (as the reply to the request) and move on to other commands
+	}
+	else if (msgd == MSG10)
+		vaccineStatusBatch(monitor, message);
+	else if (msgd == MSG12)
+	{
+		int accepted, rejected;
+		if (decode_msg12(msgd, message, &accepted, &rejected) < 0)
+			return -1;
+		monitor->accepted += accepted;
+		monitor->rejected += rejected;
+
 		send_message(monitor->write_fd, DONE, NULL, monitor->bufferSize);	// notify parent you are done and move on to other commands
 	}
 
@@ -334,10 +439,12 @@ int Monitor_take_action(struct Monitor * monitor, int msgd, void * message, char
 void vaccineStatus(struct Monitor * monitor, char * citizenID, char * virusName)
 {
 	// search for an existing cititzen record with given citizen ID
-	M_CitizenInfo citizen_info = (M_CitizenInfo) hash_search(monitor->citizens_info, citizenID);
+	M_CitizenInfo citizen_info = (M_CitizenInfo) id_index_search(monitor->citizens_info, citizenID);
 	if (citizen_info == NULL && virusName != NULL)
 	{
 		fprintf(stderr, "Error : Monitor -> vaccineStatus -> Given citizen ID does not exist in Monitor's database\n\n");
+		// still answered (with NO, as vaccineStatusBatch does), since the travelMonitor waits for the reply to each request
+		send_message_id(monitor->write_fd, MSG4, monitor->req_id, create_msg4("NO", DATE_NONE), monitor->bufferSize);
 		return;
 	}
 
@@ -348,13 +455,16 @@ void vaccineStatus(struct Monitor * monitor, char * citizenID, char * virusName)
 		if (virus_info == NULL)
 		{
 			fprintf(stderr, "Error : Monitor -> vaccineStatus -> Given virus name does not exist in Monitors's database\n\n");
+			send_message_id(monitor->write_fd, MSG4, monitor->req_id, create_msg4("NO", DATE_NONE), monitor->bufferSize);
 			return;
 		}
 
-		char * date = NULL;
+		unsigned int date = DATE_NONE;
+		bool vaccinated = false;
 		void * message;
 
-		if (!skip_list_search(m_get_vacc_list(virus_info), citizenID, &date))		// if citizen id was not found into vaccinated skip list for given virus
+		m_citizen_find_record(citizen_info, m_get_virus_id(virus_info), &vaccinated, &date);
+		if (!vaccinated)		// if citizen was not vaccinated for given virus (or has no record for it)
 		{
 			message = create_msg4("NO", date);		// construct message
 			//monitor->rejected += 1;
@@ -365,7 +475,7 @@ void vaccineStatus(struct Monitor * monitor, char * citizenID, char * virusName)
 			//monitor->accepted += 1;
 		}
 
-		send_message(monitor->write_fd, MSG4, message, monitor->bufferSize);	// send message
+		send_message_id(monitor->write_fd, MSG4, monitor->req_id, message, monitor->bufferSize);	// send message, as the reply to the request
 	}
 	else		// no specific virusName was given (i.e. query /searchVaccinationStatus )
 	{
@@ -374,23 +484,16 @@ void vaccineStatus(struct Monitor * monitor, char * citizenID, char * virusName)
 			// create message of type MSG6
 			void * message = create_msg6(m_get_citizen_name(citizen_info), m_get_citizen_surname(citizen_info), m_get_citizen_country(citizen_info), m_get_citizen_age(citizen_info));
 			send_message(monitor->write_fd, MSG6, message, monitor->bufferSize);  // to start things off, send back name,surname,country,age about given citizenID 
-			// and then send back all vaccination info you can find for given citizenID
-			M_VirusInfo virus_info;
-			// iterate upon the hash-table of viruses
-			while ((virus_info = hash_iterate_next(monitor->viruses_info)) != NULL)
+			// and then send back all vaccination info you can find for given citizenID, i.e. its vaccination records
+			// (if citizen is not associated with particular virus, then we dont send back anything)
+			for (int i = 0; i < m_citizen_records(citizen_info); ++i)
 			{
-				char * date = NULL;
-				if (skip_list_search(m_get_vacc_list(virus_info), citizenID, &date))		// if citizen id was found into vaccinated skip list for given virus
-				{
-					void * message = create_msg7(m_get_virus_name(virus_info), "YES", date);	// create message of type MSG7
-					send_message(monitor->write_fd, MSG7, message, monitor->bufferSize);
-				}
-				else if (skip_list_search(m_get_non_vacc_list(virus_info), citizenID, &date)) // if citizen id was found into not vaccinated list for given virus
-				{
-					void * message = create_msg7(m_get_virus_name(virus_info), "NO", date);
-					send_message(monitor->write_fd, MSG7, message, monitor->bufferSize);
-				}
-				// if citizen is not associated with particular virus, then we dont send back anything
+				int virus_id;
+				bool vaccinated;
+				unsigned int date;
+				m_citizen_get_record(citizen_info, i, &virus_id, &vaccinated, &date);
+				void * message = create_msg7(m_get_virus_name(monitor->viruses_by_id[virus_id]), vaccinated ? "YES" : "NO", date);	// create message of type MSG7
+				send_message(monitor->write_fd, MSG7, message, monitor->bufferSize);
 			}
 			
 		}
@@ -399,14 +502,43 @@ void vaccineStatus(struct Monitor * monitor, char * citizenID, char * virusName)
 	}
 }
 
+void vaccineStatusBatch(struct Monitor * monitor, void * message)
+{
+	int count;
+	if (decode_msg10(MSG10, message, &count) < 0)
+		return;
+
+	void * response_msg = create_msg11(count);		// one answer for each query, in the same order
+	for (int i = 0; i < count; ++i)
+	{
+		char citizenID[6], virus[20];
+		unsigned int date = DATE_NONE;
+		bool vaccinated = false;
+		get_msg10_query(message, i, citizenID, virus);
+
+		// an unknown citizen or virus is answered with NO, so that every query of the batch gets an answer
+		M_VirusInfo virus_info = (M_VirusInfo) hash_search(monitor->viruses_info, virus);
+		M_CitizenInfo citizen_info = (M_CitizenInfo) id_index_search(monitor->citizens_info, citizenID);
+		if (citizen_info != NULL && virus_info != NULL &&
+			m_citizen_find_record(citizen_info, m_get_virus_id(virus_info), &vaccinated, &date) && vaccinated)
+			set_msg11_answer(response_msg, i, "YES", date);
+		else
+			set_msg11_answer(response_msg, i, "NO", DATE_NONE);
+	}
+
+	send_message_id(monitor->write_fd, MSG11, monitor->req_id, response_msg, monitor->bufferSize);	// send message, as the reply to the batch
+}
+
 
 /*==================== EXIT PHASE ========================== */
 
 void Monitor_del(struct Monitor * monitor)
 {
-	hash_destroy(monitor->countries_info);
-	hash_destroy(monitor->citizens_info);
-	hash_destroy(monitor->viruses_info);
+	state_destroy(monitor);
+	for (int i = 0; i < monitor->num_subdirs; ++i)
+		free(monitor->subdirs[i]);
+	free(monitor->subdirs);
+	free(monitor->snapshot_path);
 	close(monitor->read_fd);
 	close(monitor->write_fd);
 	free(monitor);
@@ -429,11 +561,20 @@ void m_log_file_print(struct Monitor * monitor)
 
 	M_CountryInfo country_info;
 	// iterate upon the hash-table of countries of Monitor
-	while ((country_info = (M_CountryInfo) hash_iterate_next(monitor->countries_info)) != NULL)
+	struct hash_cursor cursor;
+	hash_cursor_init(monitor->countries_info, &cursor);
+	while ((country_info = (M_CountryInfo) hash_cursor_next(&cursor)) != NULL)
 		fprintf(file_ptr, "%s\n", m_get_country_name(country_info));				// print all countries that participated in travelMonitor
 	fprintf(file_ptr, "TOTAL TRAVEL REQUESTS %d\n", monitor->accepted + monitor->rejected);		// print total travel requests
 	fprintf(file_ptr, "ACCEPTED %d\n", monitor->accepted);								// print the #accepted
 	fprintf(file_ptr, "REJECTED %d\n", monitor->rejected);								// print the #rejected
+
+	long live[POOL_CLASSES + 1], slabs;
+	pool_stats(live, &slabs);
+	fprintf(file_ptr, "POOL LIVE");															// print the live pool objects of each size class
+	for (int c = 0; c < POOL_CLASSES; ++c)
+		fprintf(file_ptr, " %d:%ld", POOL_MIN_SIZE << c, live[c]);
+	fprintf(file_ptr, " LARGE:%ld SLABS %ld\n", live[POOL_CLASSES], slabs);
 	fclose(file_ptr);
 }
 
@@ -445,14 +586,14 @@ int read_subdir_updates(struct Monitor * monitor, char * subdir)
 	// send back the bloom filters
 	M_VirusInfo virus_info;
 	// iterate upon the hash-table of viruses
-	while ((virus_info = hash_iterate_next(monitor->viruses_info)) != NULL)
-	{
-		void * response_msg = create_msg2(m_get_virus_name(virus_info), monitor->bloom_size , m_get_bloom_filter(virus_info));	// create message
-		send_message(monitor->write_fd, MSG2, response_msg, monitor->bufferSize);				// send message
-	}
+	struct hash_cursor cursor;
+	hash_cursor_init(monitor->viruses_info, &cursor);
+	while ((virus_info = hash_cursor_next(&cursor)) != NULL)
+		send_bloom_filter(monitor, virus_info);
 
 	/* when you are done with sending the updated bloom filters, notify parent that you are done and ready for other commands */
 	send_message(monitor->write_fd, DONE, NULL, monitor->bufferSize);
+	m_snapshot_save(monitor);		// so that a replacement has the new files too
 	return 0;
 
 }
\ No newline at end of file
@@ -2,6 +2,12 @@
 /* important helper functions and structs for Monitor are developed here */
 #pragma once
 #include "hash.h"
+#include "id_index.h"
+#include "m_items.h"
+#include "arena.h"
+#include "intern.h"
+
+typedef struct m_shard * M_Shard;		// the part of a monitor that a thread inserts records into (see m_ingest.h)
 
 struct Monitor {
 	int accepted;
@@ -9,12 +15,20 @@ struct Monitor {
 	int bufferSize;
 	int read_fd;
 	int write_fd;
-	HT citizens_info;
+	IdIndex citizens_info;		// citizens by citizenID
+	Arena citizens_arena;		// where the citizens and their ids and names are allocated, freed at once by Monitor_del
+	Intern names;				// the distinct first names and surnames of the citizens (in citizens_arena)
 	HT viruses_info;
+	M_VirusInfo * viruses_by_id;		// viruses by id (see m_get_virus_id)
 	HT countries_info;
 	unsigned int bloom_size;
-	int max_level;
-	float p;
+	unsigned int options;	// options of the bloom filters, as sent by the travelMonitor (see messages.h)
+	unsigned int hashes;	// number of hash functions of the bloom filters, as sent by the travelMonitor
+	unsigned int threads;	// number of threads that read the files of records, and of shards (see m_ingest.h), as sent by the travelMonitor
+	int req_id;			// request id of the message currently handled, the replies to it carry the same request id
+	char ** subdirs;		// the subdirectories (countries) assigned to the Monitor
+	int num_subdirs;
+	char * snapshot_path;	// file where the snapshot of the Monitor is kept (see m_snapshot.h), NULL if it keeps none
 };
 
 /*__________________________________________________________________________*/
@@ -23,15 +37,17 @@ struct Monitor {
 /*===================== INITIALIZATION PHASE ===========================*/
 
 /* initializes the monitor structure and all its substructures needed */
-struct Monitor * Monitor_init(int bufferSize, unsigned int bloom_size, int max_level, float p);
-/* read bufferSize and bloom_size from travelMonitor*/
-int read_buffer_bloom_size(int * bufferSize, unsigned int * bloom_size, int read_fd, int write_fd);
+struct Monitor * Monitor_init(int bufferSize, unsigned int bloom_size, unsigned int options, unsigned int hashes, unsigned int threads);
+/* read bufferSize and bloom_size (and options, hashes, threads) from travelMonitor*/
+int read_buffer_bloom_size(int * bufferSize, unsigned int * bloom_size, unsigned int * options, unsigned int * hashes, unsigned int * threads, int read_fd, int write_fd);
 /* reads all the subdirectories assigned by travelMonitor, and then returns the bloom filters back */
 int read_subdirs(struct Monitor * monitor);
 /* reads the subdirectory indicated by char * subdir and updates structures */
 int read_subdir(struct Monitor * monitor, char * subdir);
-/* inserts given entry/line from file into all the necessary data structures of the monitor */
-void Monitor_insert(struct Monitor * monitor, char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date);
+/* creates a new virus, with the next virus id, and adds it to the viruses of the monitor */
+M_VirusInfo Monitor_add_virus(struct Monitor * monitor, char * virusName);
+/* inserts given entry/line from file into all the necessary data structures of the monitor, or of given shard of it (NULL : the monitor) */
+void Monitor_insert(struct Monitor * monitor, M_Shard shard, char * citizenID , char * firstName, char * lastName, char * country, unsigned int age, char * virusName, char * vacc, char * date);
 
 
 /* =================== QUERY PHASE ========================= */
@@ -39,6 +55,8 @@ void Monitor_insert(struct Monitor * monitor, char * citizenID , char * firstNam
 /* monitor process takes an action depending on the message it received */
 int Monitor_take_action(struct Monitor * monitor, int msgd, void * message, char * subdir);
 void vaccineStatus(struct Monitor * monitor, char * citizenID, char * virusName);
+/* answers a batch of queries (message of type MSG10) with one message of type MSG11 */
+void vaccineStatusBatch(struct Monitor * monitor, void * message);
 
 /*==================== EXIT PHASE ========================== */
 /* destroys the monitor structure and all of its substructures that were created and used, closes open file descriptors */
@@ -0,0 +1,627 @@
+/* file : m_ingest.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "m_ingest.h"
+#include "m_helper.h"
+#include "bloom.h"
+#include "hash.h"
+#include "id_index.h"
+#include "m_items.h"
+
+#define BATCH_PENDING 0		// not parsed yet
+#define BATCH_READY 1		// parsed, its records can be inserted
+#define BATCH_FAILED 2		// file could not be read
+#define BATCH_RELEASED 3	// its records were inserted by every shard, and it was released
+
+struct record {				// a record of a file (a line), its fields point into the text of the file
+	char * citizenID, * firstName, * lastName, * country, * virusName, * vacc, * date;
+	int age;
+	int shard;				// shard of the citizen (see m_citizen_shard), whose thread inserts the record
+};
+
+struct batch {				// the records of a file
+	char * text;			// contents of the file, mapped (or read) into memory
+	size_t size;			// size of text
+	bool mapped;			// true if text is mapped, false if it was read
+	struct record * records;
+	int count;
+	int status;				// one of the above
+	int done;				// shards that have inserted their records of the batch
+};
+
+struct ingest {				// shared by the threads of the shards
+	struct Monitor * monitor;
+	char ** paths;
+	struct batch * batches;	// a batch for each file
+	int count;				// number of files
+	int shards;				// number of shards (and threads)
+	int next;				// next file to be parsed
+	int released;			// files whose records have been inserted by every shard, files from released + window on are not parsed yet
+	int window;
+	pthread_mutex_t lock;	// guards the above
+	pthread_cond_t changed;	// a batch was parsed, or released (so the window moved)
+	pthread_mutex_t tables;	// guards the viruses and countries of the monitor, and the keys of its citizens, while the shards insert
+};
+
+// an insert into (or a removal from) a counting bloom filter by a shard, it is done when the shards are merged, since counters cannot be or-ed
+struct bloom_op {
+	M_VirusInfo virus;
+	char * id;
+	bool insert;
+};
+
+// an error of a record, found by a shard, its text is in the errors of the shard
+struct shard_error {
+	uint64_t position;		// position of the record (file << 32 | record of file), the errors are printed in this order
+	size_t offset;			// of the text of the error
+};
+
+struct m_shard {
+	struct ingest * ingest;
+	int index;
+	IdIndex citizens;		// the citizens created by the shard, they are moved into the monitor when the shards are merged
+	Arena arena;			// where they are allocated, merged into the arena of the monitor
+	Intern names;			// their names (in arena)
+	HT viruses;				// the viruses of the monitor met by the shard, so that the table of the monitor is seldom locked
+	HT countries;			// the countries of the monitor met by the shard
+	Bloom * blooms;			// by virus id, the vaccinated citizens the shard inserted, or-ed into the bloom filter of the virus when merged
+	int num_blooms;			// (NULL if the shard inserted none, or the bloom filter is counting)
+	struct bloom_op * ops;	// inserts into the counting bloom filters, in order
+	int num_ops;
+	int ops_capacity;
+	char * text;			// the texts of the errors of the shard, each one terminated with a '\0'
+	size_t text_length;
+	size_t text_capacity;
+	struct shard_error * errors;
+	int num_errors;
+	int errors_capacity;
+	uint64_t position;		// position of the record being inserted
+};
+
+// maps the file of given fd and size into batch->text, privately and writable, so that the fields of the records can be terminated in place
+// (only the pages written to are copied, by the kernel), the text is followed by a '\0' or ends with a newline
+// if there is no room for it (the file fills its last page and does not end with a newline), the file is read into memory instead
+static int load_file(int fd, size_t size, struct batch * batch)
+{
+	batch->size = size;
+	batch->mapped = false;
+	if (size == 0)
+	{
+		batch->text = NULL;
+		return 0;
+	}
+
+	batch->text = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (batch->text != MAP_FAILED)
+	{
+		if (size % sysconf(_SC_PAGESIZE) != 0 || batch->text[size - 1] == '\n')	// the rest of the last page reads as zeros
+		{
+			batch->mapped = true;
+			madvise(batch->text, size, MADV_SEQUENTIAL);
+			return 0;
+		}
+		munmap(batch->text, size);
+	}
+
+	batch->text = malloc(size + 1);
+	if (batch->text == NULL)
+		fprintf(stderr, "Error : load_file -> malloc\n");
+	assert(batch->text != NULL);
+	size_t done = 0;
+	ssize_t n;
+	while (done < size && (n = pread(fd, batch->text + done, size - done, done)) > 0)
+		done += n;
+	batch->text[done] = '\0';
+	batch->size = done;
+	return 0;
+}
+
+// unmaps (or frees) the text of batch, along with its records
+static void release_batch(struct batch * batch)
+{
+	if (batch->mapped)
+		munmap(batch->text, batch->size);
+	else
+		free(batch->text);
+	free(batch->records);
+}
+
+// returns the integer at the start of str, like atoi
+static inline int parse_int(const char * str)
+{
+	bool negative = (*str == '-');
+	if (negative || *str == '+')
+		str++;
+	int value = 0;
+	for (; *str >= '0' && *str <= '9'; str++)
+		value = value * 10 + (*str - '0');
+	return negative ? -value : value;
+}
+
+// reads and parses the file at path into batch, each line is a record : citizenID firstName lastName country age virusName YES/NO [date]
+// the lines and the fields are found with memchr (vectorized), and each field is terminated in place, so the records point into the text
+// each record is given the shard of its citizen, out of given shards
+static int parse_file(char * path, struct batch * batch, int shards)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	load_file(fd, st.st_size, batch);
+	close(fd);
+
+	int capacity = 64;
+	batch->records = malloc(capacity * sizeof(struct record));
+	batch->count = 0;
+	if (batch->records == NULL)
+		fprintf(stderr, "Error : parse_file -> malloc\n");
+	assert(batch->records != NULL);
+
+	char * text_end = batch->text + batch->size;
+	for (char * line = batch->text; line < text_end; )
+	{
+		char * line_end = memchr(line, '\n', text_end - line);
+		if (line_end == NULL)
+			line_end = text_end;		// last line, without a newline
+		char * next = line_end + 1;
+		if (line_end > line && line_end[-1] == '\r')
+			line_end--;
+
+		char * fields[8] = { NULL };
+		int i = 0;
+		for (char * field = line; field < line_end && i < 8; )
+		{
+			char * field_end = memchr(field, ' ', line_end - field);
+			if (field_end == NULL)
+				field_end = line_end;
+			if (field_end > field)		// consecutive spaces separate no field
+			{
+				*field_end = '\0';		// a space, the end of the line, or the '\0' after the text
+				fields[i++] = field;
+			}
+			field = field_end + 1;
+		}
+		line = next;
+		if (i < 7)		// not a record (e.g. an empty line)
+			continue;
+
+		if (batch->count == capacity)
+		{
+			capacity *= 2;
+			batch->records = realloc(batch->records, capacity * sizeof(struct record));
+			if (batch->records == NULL)
+				fprintf(stderr, "Error : parse_file -> realloc\n");
+			assert(batch->records != NULL);
+		}
+		struct record * record = &batch->records[batch->count++];
+		record->citizenID = fields[0];
+		record->firstName = fields[1];
+		record->lastName = fields[2];
+		record->country = fields[3];
+		record->age = parse_int(fields[4]);
+		record->virusName = fields[5];
+		record->vacc = fields[6];
+		record->date = fields[7];		// NULL if there is no date
+		record->shard = m_citizen_shard(record->citizenID, shards);
+	}
+	return 0;
+}
+
+// inserts the records of batch into monitor, and releases it
+static void insert_batch(struct Monitor * monitor, struct batch * batch)
+{
+	for (int i = 0; i < batch->count; ++i)
+	{
+		struct record * r = &batch->records[i];
+		Monitor_insert(monitor, NULL, r->citizenID, r->firstName, r->lastName, r->country, r->age, r->virusName, r->vacc, r->date);
+	}
+	release_batch(batch);
+}
+
+/*__________________________________ SHARDS __________________________________*/
+
+// makes room in array (of elements of given size) for one more element after the first count ones
+static void * make_room(void * array, int count, int * capacity, size_t size)
+{
+	if (count < *capacity)
+		return array;
+	*capacity = (*capacity == 0) ? 64 : 2 * *capacity;
+	array = realloc(array, *capacity * size);
+	if (array == NULL)
+		fprintf(stderr, "Error : make_room -> realloc\n");
+	assert(array != NULL);
+	return array;
+}
+
+static M_Shard shard_create(struct ingest * ingest, int index)
+{
+	M_Shard shard = malloc(sizeof(struct m_shard));
+	if (shard == NULL)
+		fprintf(stderr, "Error : shard_create -> malloc\n");
+	assert(shard != NULL);
+
+	shard->ingest = ingest;
+	shard->index = index;
+	shard->citizens = id_index_create((HashKey) m_get_citizen_id, NULL);		// the monitor deletes them
+	shard->arena = arena_create();
+	shard->names = intern_create(shard->arena);
+	shard->viruses = hash_create(8, (HashKey) m_get_virus_name, NULL);
+	shard->countries = hash_create(8, (HashKey) m_get_country_name, NULL);
+	shard->blooms = NULL;
+	shard->num_blooms = 0;
+	shard->ops = NULL;
+	shard->num_ops = 0;
+	shard->ops_capacity = 0;
+	shard->text = NULL;
+	shard->text_length = 0;
+	shard->text_capacity = 0;
+	shard->errors = NULL;
+	shard->num_errors = 0;
+	shard->errors_capacity = 0;
+	return shard;
+}
+
+M_CitizenInfo m_shard_search_citizen(M_Shard shard, char * id)
+{
+	M_CitizenInfo citizen = id_index_search(shard->citizens, id);
+	if (citizen == NULL)		// the citizens of the monitor are not changed while the shards insert, they are only read
+		citizen = id_index_search(shard->ingest->monitor->citizens_info, id);
+	return citizen;
+}
+
+M_VirusInfo m_shard_search_virus(M_Shard shard, char * name)
+{
+	M_VirusInfo virus = hash_search(shard->viruses, name);
+	if (virus != NULL)
+		return virus;
+	pthread_mutex_lock(&shard->ingest->tables);
+	virus = hash_search(shard->ingest->monitor->viruses_info, name);
+	pthread_mutex_unlock(&shard->ingest->tables);
+	if (virus != NULL)
+		hash_insert(shard->viruses, virus);
+	return virus;
+}
+
+M_VirusInfo m_shard_add_virus(M_Shard shard, char * name)
+{
+	struct Monitor * monitor = shard->ingest->monitor;
+	pthread_mutex_lock(&shard->ingest->tables);
+	M_VirusInfo virus = hash_search(monitor->viruses_info, name);		// another shard may have added it meanwhile
+	if (virus == NULL)
+		virus = Monitor_add_virus(monitor, name);
+	pthread_mutex_unlock(&shard->ingest->tables);
+	hash_insert(shard->viruses, virus);
+	return virus;
+}
+
+M_CountryInfo m_shard_search_country(M_Shard shard, char * name)
+{
+	M_CountryInfo country = hash_search(shard->countries, name);
+	if (country != NULL)
+		return country;
+	pthread_mutex_lock(&shard->ingest->tables);
+	country = hash_search(shard->ingest->monitor->countries_info, name);
+	pthread_mutex_unlock(&shard->ingest->tables);
+	if (country != NULL)
+		hash_insert(shard->countries, country);
+	return country;
+}
+
+M_CountryInfo m_shard_add_country(M_Shard shard, char * name)
+{
+	struct Monitor * monitor = shard->ingest->monitor;
+	pthread_mutex_lock(&shard->ingest->tables);
+	M_CountryInfo country = hash_search(monitor->countries_info, name);
+	if (country == NULL)
+	{
+		country = m_country_info_create(name);
+		hash_insert(monitor->countries_info, country);
+	}
+	pthread_mutex_unlock(&shard->ingest->tables);
+	hash_insert(shard->countries, country);
+	return country;
+}
+
+M_CitizenInfo m_shard_add_citizen(M_Shard shard, char * id, char * name, char * surname, int age, M_CountryInfo country)
+{
+	uint64_t key;
+	if (!id_index_code(id, &key))		// the ids without a code take the next free key of the monitor
+	{
+		pthread_mutex_lock(&shard->ingest->tables);
+		key = id_index_key(shard->ingest->monitor->citizens_info, id);
+		pthread_mutex_unlock(&shard->ingest->tables);
+	}
+	M_CitizenInfo citizen = m_citizen_info_create(shard->arena, shard->names, id, key, name, surname, age, country);
+	id_index_insert(shard->citizens, citizen);
+	return citizen;
+}
+
+// adds an insert into (or a removal from) the counting bloom filter of virus, to be done when the shards are merged
+static void add_bloom_op(M_Shard shard, M_VirusInfo virus, M_CitizenInfo citizen, bool insert)
+{
+	shard->ops = make_room(shard->ops, shard->num_ops, &shard->ops_capacity, sizeof(struct bloom_op));
+	struct bloom_op * op = &shard->ops[shard->num_ops++];
+	op->virus = virus;
+	op->id = m_get_citizen_id(citizen);		// in an arena, it outlives the records
+	op->insert = insert;
+}
+
+void m_shard_bloom_insert(M_Shard shard, M_VirusInfo virus, M_CitizenInfo citizen)
+{
+	Bloom bloom = m_get_bloom_filter(virus);
+	if (bloom->counters != NULL)
+	{
+		add_bloom_op(shard, virus, citizen, true);
+		return;
+	}
+
+	int id = m_get_virus_id(virus);
+	if (id >= shard->num_blooms)
+	{
+		shard->blooms = realloc(shard->blooms, (id + 1) * sizeof(Bloom));
+		if (shard->blooms == NULL)
+			fprintf(stderr, "Error : m_shard_bloom_insert -> realloc\n");
+		assert(shard->blooms != NULL);
+		for (; shard->num_blooms <= id; ++shard->num_blooms)
+			shard->blooms[shard->num_blooms] = NULL;
+	}
+	if (shard->blooms[id] == NULL)		// same size, hash functions and layout as the bloom filter of the virus, so that they can be or-ed
+		shard->blooms[id] = bloom_create(bloom->size / 8, bloom->k, bloom->blocked);
+	bloom_insert(shard->blooms[id], (unsigned char *) m_get_citizen_id(citizen));
+}
+
+void m_shard_bloom_remove(M_Shard shard, M_VirusInfo virus, M_CitizenInfo citizen)
+{
+	add_bloom_op(shard, virus, citizen, false);		// only counting bloom filters have removals
+}
+
+void m_shard_error(M_Shard shard, const char * format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	va_list copy;
+	va_copy(copy, args);
+	size_t length = vsnprintf(NULL, 0, format, copy) + 1;
+	va_end(copy);
+
+	if (shard->text_length + length > shard->text_capacity)
+	{
+		shard->text_capacity = 2 * (shard->text_length + length);
+		shard->text = realloc(shard->text, shard->text_capacity);
+		if (shard->text == NULL)
+			fprintf(stderr, "Error : m_shard_error -> realloc\n");
+		assert(shard->text != NULL);
+	}
+	vsnprintf(shard->text + shard->text_length, length, format, args);
+	va_end(args);
+
+	shard->errors = make_room(shard->errors, shard->num_errors, &shard->errors_capacity, sizeof(struct shard_error));
+	shard->errors[shard->num_errors].position = shard->position;
+	shard->errors[shard->num_errors++].offset = shard->text_length;
+	shard->text_length += length;
+}
+
+// prints the errors of all the shards, in the order of their records (the errors of each shard are in order already)
+static void print_errors(M_Shard * shards, int count)
+{
+	int * next = calloc(count, sizeof(int));
+	if (next == NULL)
+		fprintf(stderr, "Error : print_errors -> calloc\n");
+	assert(next != NULL);
+	while (1)
+	{
+		int first = -1;
+		for (int i = 0; i < count; ++i)
+			if (next[i] < shards[i]->num_errors && (first < 0 ||
+				shards[i]->errors[next[i]].position < shards[first]->errors[next[first]].position))
+				first = i;
+		if (first < 0)
+			break;
+		fputs(shards[first]->text + shards[first]->errors[next[first]++].offset, stdout);
+	}
+	free(next);
+}
+
+static void insert_citizen(void * citizen, void * index)
+{
+	id_index_insert(index, citizen);
+}
+
+// moves what the shard inserted into the monitor, and deletes the shard
+static void shard_merge(struct Monitor * monitor, M_Shard shard)
+{
+	id_index_traverse(shard->citizens, insert_citizen, monitor->citizens_info);
+	id_index_destroy(shard->citizens);
+	intern_destroy(shard->names);		// the names stay in the arena, a name may now be kept once per shard
+	arena_merge(monitor->citizens_arena, shard->arena);
+
+	for (int id = 0; id < shard->num_blooms; ++id)
+		if (shard->blooms[id] != NULL)
+		{
+			bloom_merge(m_get_bloom_filter(monitor->viruses_by_id[id]), shard->blooms[id]);
+			bloom_destroy(shard->blooms[id]);
+		}
+	for (int i = 0; i < shard->num_ops; ++i)
+	{
+		Bloom bloom = m_get_bloom_filter(shard->ops[i].virus);
+		if (shard->ops[i].insert)
+			bloom_insert(bloom, (unsigned char *) shard->ops[i].id);
+		else
+			bloom_remove(bloom, (unsigned char *) shard->ops[i].id);
+	}
+
+	hash_destroy(shard->viruses);
+	hash_destroy(shard->countries);
+	free(shard->blooms);
+	free(shard->ops);
+	free(shard->text);
+	free(shard->errors);
+	free(shard);
+}
+
+// waits until file i is parsed, and returns its status, meanwhile the thread parses the next files (as far as the window goes)
+static int wait_batch(struct ingest * ingest, int i)
+{
+	pthread_mutex_lock(&ingest->lock);
+	while (ingest->batches[i].status == BATCH_PENDING)
+	{
+		if (ingest->next < ingest->count && ingest->next < ingest->released + ingest->window)
+		{
+			int j = ingest->next++;
+			pthread_mutex_unlock(&ingest->lock);
+
+			int status = (parse_file(ingest->paths[j], &ingest->batches[j], ingest->shards) < 0) ? BATCH_FAILED : BATCH_READY;
+
+			pthread_mutex_lock(&ingest->lock);
+			ingest->batches[j].status = status;
+			pthread_cond_broadcast(&ingest->changed);
+		}
+		else
+			pthread_cond_wait(&ingest->changed, &ingest->lock);
+	}
+	int status = ingest->batches[i].status;
+	pthread_mutex_unlock(&ingest->lock);
+	return status;
+}
+
+// marks file i as inserted by one more shard, the last one releases it, so that the window moves
+static void batch_done(struct ingest * ingest, int i)
+{
+	pthread_mutex_lock(&ingest->lock);
+	bool last = (++ingest->batches[i].done == ingest->shards);
+	pthread_mutex_unlock(&ingest->lock);
+	if (!last)
+		return;
+
+	release_batch(&ingest->batches[i]);
+	pthread_mutex_lock(&ingest->lock);
+	ingest->batches[i].status = BATCH_RELEASED;
+	while (ingest->released < ingest->count && ingest->batches[ingest->released].status == BATCH_RELEASED)
+		ingest->released++;
+	pthread_cond_broadcast(&ingest->changed);
+	pthread_mutex_unlock(&ingest->lock);
+}
+
+// the thread of a shard, inserts the records of the shard of every file, in order, until the last file or a file that could not be read
+static void * shard_thread(void * arg)
+{
+	M_Shard shard = arg;
+	struct ingest * ingest = shard->ingest;
+	for (int i = 0; i < ingest->count; ++i)
+	{
+		if (wait_batch(ingest, i) == BATCH_FAILED)
+			break;
+		struct batch * batch = &ingest->batches[i];
+		for (int j = 0; j < batch->count; ++j)
+		{
+			struct record * r = &batch->records[j];
+			if (r->shard != shard->index)
+				continue;
+			shard->position = ((uint64_t) i << 32) | (uint32_t) j;
+			Monitor_insert(ingest->monitor, shard, r->citizenID, r->firstName, r->lastName, r->country, r->age, r->virusName, r->vacc, r->date);
+		}
+		batch_done(ingest, i);
+	}
+	return NULL;
+}
+
+int m_ingest_files(struct Monitor * monitor, char ** paths, int count)
+{
+	int shards = monitor->threads;
+	if (shards <= 1)		// no threads, each file is parsed right before its records are inserted
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			struct batch batch;
+			if (parse_file(paths[i], &batch, 1) < 0)
+			{
+				fprintf(stderr, "[Error] : m_ingest_files -> could not read file %s\n", paths[i]);
+				return -1;
+			}
+			insert_batch(monitor, &batch);
+		}
+		return 0;
+	}
+	if (count == 0)
+		return 0;
+
+	struct ingest ingest;
+	ingest.monitor = monitor;
+	ingest.paths = paths;
+	ingest.count = count;
+	ingest.shards = shards;
+	ingest.next = 0;
+	ingest.released = 0;
+	ingest.window = INGEST_AHEAD * shards;
+	ingest.batches = calloc(count, sizeof(struct batch));		// all pending
+	M_Shard * shard = malloc(shards * sizeof(M_Shard));
+	pthread_t * threads = malloc(shards * sizeof(pthread_t));
+	bool * started = calloc(shards, sizeof(bool));
+	if (ingest.batches == NULL || shard == NULL || threads == NULL || started == NULL)
+		fprintf(stderr, "Error : m_ingest_files -> malloc\n");
+	assert(ingest.batches != NULL && shard != NULL && threads != NULL && started != NULL);
+	pthread_mutex_init(&ingest.lock, NULL);
+	pthread_cond_init(&ingest.changed, NULL);
+	pthread_mutex_init(&ingest.tables, NULL);
+
+	// the shard 0 runs on this thread, the rest on threads of their own
+	for (int i = 0; i < shards; ++i)
+		shard[i] = shard_create(&ingest, i);
+	bool all_started = true;
+	for (int i = 1; i < shards; ++i)
+		all_started &= (started[i] = (pthread_create(&threads[i], NULL, shard_thread, shard[i]) == 0));
+	if (!all_started)		// the shards that could not get a thread run here after shard 0, so the files are not released until then
+	{
+		perror("[Error] : m_ingest_files -> pthread_create");
+		pthread_mutex_lock(&ingest.lock);
+		ingest.window = count;
+		pthread_cond_broadcast(&ingest.changed);
+		pthread_mutex_unlock(&ingest.lock);
+	}
+	shard_thread(shard[0]);
+	for (int i = 1; i < shards; ++i)
+		if (!started[i])
+			shard_thread(shard[i]);
+	for (int i = 1; i < shards; ++i)
+		if (started[i])
+			pthread_join(threads[i], NULL);
+
+	// the shards stop at the same file, if one could not be read
+	int result = 0;
+	for (int i = 0; i < count && result == 0; ++i)
+		if (ingest.batches[i].status == BATCH_FAILED)
+		{
+			fprintf(stderr, "[Error] : m_ingest_files -> could not read file %s\n", paths[i]);
+			result = -1;
+		}
+	for (int i = 0; i < count; ++i)		// batches parsed but not inserted (after a failed file)
+		if (ingest.batches[i].status == BATCH_READY)
+			release_batch(&ingest.batches[i]);
+
+	print_errors(shard, shards);
+	for (int i = 0; i < shards; ++i)
+		shard_merge(monitor, shard[i]);
+
+	pthread_mutex_destroy(&ingest.lock);
+	pthread_cond_destroy(&ingest.changed);
+	pthread_mutex_destroy(&ingest.tables);
+	free(ingest.batches);
+	free(shard);
+	free(threads);
+	free(started);
+	return result;
+}
@@ -0,0 +1,34 @@
+/* file : m_ingest.h */
+/* ingestion of the files of records of a Monitor, with monitor->threads threads : the monitor is split into that many shards by citizen */
+/* (see m_citizen_shard), and the thread of each shard inserts the records of its citizens (Monitor_insert), in the order of the files, */
+/* into the citizens, arena and bloom filters of its own, and into the trees of the viruses for its shard.  The threads also read and */
+/* parse the files ahead, as they wait for them.  At the end the shards are merged into the monitor (their citizens are moved, their */
+/* bloom filters or-ed into the ones of the viruses), and the errors they found are printed in the order of the records, so that the */
+/* result (and the errors reported) are the same as when the files are read one by one.  The viruses and countries of the monitor are */
+/* shared by the shards, behind a lock (each shard remembers the ones it met) */
+#pragma once
+#include "m_helper.h"
+
+#define INGEST_AHEAD 2		// files per thread that can be parsed ahead of the inserts, so that memory stays bounded
+
+/* reads the records of the given count files (paths) and inserts them into monitor, with monitor->threads threads (1 : no threads) */
+/* returns 0 on success, -1 if a file could not be read (the records of the files before it are inserted) */
+int m_ingest_files(struct Monitor * monitor, char ** paths, int count);
+
+/* the part of Monitor_insert that differs for a shard (called by the thread of the shard only) : */
+/* a citizen is searched among the ones created by the shard, and then among the ones of the monitor */
+M_CitizenInfo m_shard_search_citizen(M_Shard shard, char * id);
+/* a virus or country is searched among the ones the shard met, and then (locked) among the ones of the monitor */
+M_VirusInfo m_shard_search_virus(M_Shard shard, char * name);
+M_CountryInfo m_shard_search_country(M_Shard shard, char * name);
+/* a new virus or country is added (locked) to the monitor, unless another shard added it already */
+M_VirusInfo m_shard_add_virus(M_Shard shard, char * name);
+M_CountryInfo m_shard_add_country(M_Shard shard, char * name);
+/* a new citizen is created in the arena of the shard */
+M_CitizenInfo m_shard_add_citizen(M_Shard shard, char * id, char * name, char * surname, int age, M_CountryInfo country);
+/* a vaccinated citizen is inserted into the bloom filter of the shard for virus (into the one of virus when merged, if it is counting) */
+void m_shard_bloom_insert(M_Shard shard, M_VirusInfo virus, M_CitizenInfo citizen);
+/* a vaccinated citizen is removed from the counting bloom filter of virus, when the shards are merged */
+void m_shard_bloom_remove(M_Shard shard, M_VirusInfo virus, M_CitizenInfo citizen);
+/* the error of the record being inserted (printf format) is kept, to be printed in order after the inserts */
+void m_shard_error(M_Shard shard, const char * format, ...);
@@ -2,25 +2,43 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "bloom.h"
-#include "skip_list.h"
+#include "messages.h"
+#include "bptree.h"
+#include "xor_filter.h"
 #include "list.h"
 #include "m_items.h"
 #include <assert.h>
 
+// vaccination record of a citizen for a virus
+struct m_vaccination {
+	unsigned short virus_id;	// id of the virus (see m_get_virus_id)
+	bool vaccinated;
+	unsigned int date;			// date of vaccination, as a day number (DATE_NONE if not vaccinated)
+};
+
 struct m_citizen_info {
 	char * id;
+	uint64_t key;		// integer key of the citizen in the vaccinated persons trees (see id_index_key)
 	char * name;
 	char * surname;
 	int age;
 	M_CountryInfo country;
+	struct m_vaccination * records;		// vaccination records of the citizen, one per virus (a few, so they are scanned)
+	int num_records;
+	int records_capacity;
 };
 
 struct m_virus_info {
 	char * virus_name;						// name of the virus
+	int id;									// small integer id of the virus, for the vaccination records of the citizens
 	Bloom bloom_filter;						// bloom filter for virus
-	SkipList vaccinated_persons;			// vaccinated persons skip list for virus
-	SkipList not_vaccinated_persons;		// not vaccinated persons skip list for virus
+	BPTree * vaccinated_persons;			// vaccinated persons B+trees for virus, one per shard (see m_citizen_shard), by citizen key
+											// (the not vaccinated ones are only in the records of each citizen)
+	int shards;								// number of the trees
+	bool bloom_sent;						// true if the bloom filter has been sent to the travelMonitor
+	unsigned int generation_sent;			// generation of the bloom filter when it was last sent to the travelMonitor
 };
 
 struct m_country_info {
@@ -29,21 +47,18 @@ struct m_country_info {
 	unsigned long population;
 };
 
-M_CitizenInfo m_citizen_info_create(char * id, char * name, char * surname, int age, M_CountryInfo country)
+M_CitizenInfo m_citizen_info_create(Arena arena, Intern names, char * id, uint64_t key, char * name, char * surname, int age, M_CountryInfo country)
 {
-	M_CitizenInfo info = malloc(sizeof(struct m_citizen_info));
-	if (info == NULL)
-		fprintf(stderr, "Error : m_citizen_info_create -> malloc\n");
-	assert(info != NULL);
-
-	info->id = malloc(strlen(id) + 1);
-	strcpy(info->id, id);
-	info->name = malloc(strlen(name) + 1);
-	strcpy(info->name, name);
-	info->surname = malloc(strlen(surname) + 1);
-	strcpy(info->surname, surname);
+	M_CitizenInfo info = arena_alloc(arena, sizeof(struct m_citizen_info));
+	info->id = arena_strdup(arena, id);
+	info->key = key;
+	info->name = intern_string(names, name);		// names repeat, one copy of each is kept
+	info->surname = intern_string(names, surname);
 	info->age = age;
 	info->country = country;
+	info->records = NULL;
+	info->num_records = 0;
+	info->records_capacity = 0;
 	m_country_population_inc(country);		// new citizen from given country was recorded and inserted into database
 
 	return info;
@@ -55,10 +70,7 @@ void m_citizen_info_destroy(M_CitizenInfo info)
 		fprintf(stderr, "Error : m_citizen_info_delete -> malloc\n");
 	assert(info != NULL);
 
-	free(info->id);
-	free(info->name);
-	free(info->surname);
-	free(info);
+	free(info->records);		// the rest is in the arena
 }
 
 char * m_get_citizen_id(M_CitizenInfo info)
@@ -66,6 +78,11 @@ char * m_get_citizen_id(M_CitizenInfo info)
 	return info->id;
 }
 
+uint64_t m_get_citizen_key(M_CitizenInfo info)
+{
+	return info->key;
+}
+
 char * m_get_citizen_name(M_CitizenInfo info)
 {
 	return info->name;
@@ -81,11 +98,74 @@ char * m_get_citizen_country(M_CitizenInfo info)
 	return m_get_country_name(info->country);
 }
 
+M_CountryInfo m_get_citizen_country_info(M_CitizenInfo info)
+{
+	return info->country;
+}
+
 int m_get_citizen_age(M_CitizenInfo info)
 {
 	return info->age;
 }
 
+int m_citizen_shard(char * id, int shards)
+{
+	if (shards <= 1)
+		return 0;
+	return (int) (bloom_hash((unsigned char *) id) % shards);
+}
+
+bool m_citizen_find_record(M_CitizenInfo info, int virus_id, bool * vaccinated, unsigned int * date)
+{
+	for (int i = 0; i < info->num_records; ++i)
+		if (info->records[i].virus_id == virus_id)
+		{
+			*vaccinated = info->records[i].vaccinated;
+			*date = info->records[i].date;
+			return true;
+		}
+	return false;
+}
+
+void m_citizen_set_record(M_CitizenInfo info, int virus_id, bool vaccinated, unsigned int date)
+{
+	if (virus_id < 0 || virus_id > USHRT_MAX)
+		fprintf(stderr, "Error : m_citizen_set_record -> invalid virus id\n");
+	assert(virus_id >= 0 && virus_id <= USHRT_MAX);
+
+	int i = 0;
+	while (i < info->num_records && info->records[i].virus_id != virus_id)
+		i++;
+	if (i == info->num_records)		// otherwise the previous record for this virus is replaced
+	{
+		if (info->num_records == info->records_capacity)
+		{
+			info->records_capacity = (info->records_capacity == 0) ? 2 : 2 * info->records_capacity;
+			info->records = realloc(info->records, info->records_capacity * sizeof(struct m_vaccination));
+			if (info->records == NULL)
+				fprintf(stderr, "Error : m_citizen_set_record -> realloc\n");
+			assert(info->records != NULL);
+		}
+		info->num_records++;
+	}
+
+	info->records[i].virus_id = virus_id;
+	info->records[i].vaccinated = vaccinated;
+	info->records[i].date = date;
+}
+
+int m_citizen_records(M_CitizenInfo info)
+{
+	return info->num_records;
+}
+
+void m_citizen_get_record(M_CitizenInfo info, int i, int * virus_id, bool * vaccinated, unsigned int * date)
+{
+	*virus_id = info->records[i].virus_id;
+	*vaccinated = info->records[i].vaccinated;
+	*date = info->records[i].date;
+}
+
 void m_citizen_info_print(M_CitizenInfo info)
 {
 	printf("%s %s %s %s %d\n", info->id, info->name, info->surname, m_get_country_name(info->country), info->age);
@@ -94,7 +174,7 @@ void m_citizen_info_print(M_CitizenInfo info)
 /*_______________________________________________________________________________________________________________*/
 
 
-M_VirusInfo m_virus_info_create(char * virus_name, unsigned int bloom_size, int max_level, float p)
+M_VirusInfo m_virus_info_create(char * virus_name, int id, unsigned int bloom_size, unsigned int hashes, unsigned int options, int shards)
 {
 	M_VirusInfo info = malloc(sizeof(struct m_virus_info));
 	if (info == NULL)
@@ -103,10 +183,29 @@ M_VirusInfo m_virus_info_create(char * virus_name, unsigned int bloom_size, int
 
 	info->virus_name = malloc(strlen(virus_name) + 1);
 	strcpy(info->virus_name, virus_name);
-
-	info->bloom_filter = bloom_create(bloom_size);
-	info->vaccinated_persons = skip_list_create(max_level, p);
-	info->not_vaccinated_persons = skip_list_create(max_level, p);
+	info->id = id;
+
+	// the bloom filter is made as given by the options (see messages.h)
+	bool blocked_bloom = options & OPTION_BLOCKED_BLOOM;
+	info->bloom_filter = NULL;
+	if ((options & OPTION_SHARED_BLOOM) && (info->bloom_filter = bloom_create_shared(bloom_size, hashes, blocked_bloom)) == NULL)	// keep the bit array in shared memory if possible
+		perror("Error : m_virus_info_create -> bloom_create_shared, using a private bloom filter\n");
+	if (info->bloom_filter == NULL)
+	{
+		info->bloom_filter = bloom_create(bloom_size, hashes, blocked_bloom);
+		bloom_track_dirty(info->bloom_filter);		// so that only the changed words are sent on updates
+	}
+	if (options & OPTION_COUNTING_BLOOM)
+		bloom_track_counts(info->bloom_filter);
+	info->bloom_sent = false;
+	info->generation_sent = 0;
+	info->shards = shards;
+	info->vaccinated_persons = malloc(shards * sizeof(BPTree));
+	if (info->vaccinated_persons == NULL)
+		fprintf(stderr, "Error : m_virus_info_create -> malloc\n");
+	assert(info->vaccinated_persons != NULL);
+	for (int i = 0; i < shards; ++i)
+		info->vaccinated_persons[i] = bptree_create();
 
 	return info;
 }
@@ -119,8 +218,9 @@ void m_virus_info_destroy(M_VirusInfo info)
 
 	free(info->virus_name);
 	bloom_destroy(info->bloom_filter);
-	skip_list_destroy(info->vaccinated_persons);
-	skip_list_destroy(info->not_vaccinated_persons);
+	for (int i = 0; i < info->shards; ++i)
+		bptree_destroy(info->vaccinated_persons[i]);
+	free(info->vaccinated_persons);
 
 	free(info);
 }
@@ -130,28 +230,88 @@ char * m_get_virus_name(M_VirusInfo info)
 	return info->virus_name;
 }
 
+int m_get_virus_id(M_VirusInfo info)
+{
+	return info->id;
+}
+
 Bloom m_get_bloom_filter(M_VirusInfo info)
 {
 	return info->bloom_filter;
 }
 
-SkipList m_get_vacc_list(M_VirusInfo info)
+bool m_bloom_changed(M_VirusInfo info)
+{
+	return !info->bloom_sent || info->generation_sent != info->bloom_filter->generation;
+}
+
+bool m_bloom_was_sent(M_VirusInfo info)
+{
+	return info->bloom_sent;
+}
+
+void m_bloom_sent(M_VirusInfo info)
+{
+	info->bloom_sent = true;
+	info->generation_sent = info->bloom_filter->generation;
+	bloom_clear_dirty(info->bloom_filter);		// the travelMonitor now has every word
+}
+
+struct xor_keys {			// the keys of a xor filter, collected from a B+tree
+	uint64_t * keys;
+	unsigned int count;
+	unsigned int capacity;
+};
+
+static void add_xor_key(void * data, void * arg)
+{
+	struct xor_keys * keys = arg;
+	if (keys->count == keys->capacity)
+	{
+		keys->capacity *= 2;
+		keys->keys = realloc(keys->keys, keys->capacity * sizeof(uint64_t));
+		if (keys->keys == NULL)
+			fprintf(stderr, "Error : add_xor_key -> realloc\n");
+		assert(keys->keys != NULL);
+	}
+	keys->keys[keys->count++] = bloom_hash((unsigned char *) m_get_citizen_id(data));
+}
+
+XorFilter m_build_xor_filter(M_VirusInfo info, unsigned int max_size)
 {
-	return info->vaccinated_persons;
+	struct xor_keys keys;
+	keys.count = 0;
+	keys.capacity = 64;
+	keys.keys = malloc(keys.capacity * sizeof(uint64_t));
+	if (keys.keys == NULL)
+		fprintf(stderr, "Error : m_build_xor_filter -> malloc\n");
+	assert(keys.keys != NULL);
+
+	// the vaccinated citizens are exactly the ones inserted into the bloom filter (and not removed)
+	for (int i = 0; i < info->shards; ++i)
+		bptree_traverse(info->vaccinated_persons[i], add_xor_key, &keys);
+	XorFilter filter = xor_filter_build(keys.keys, keys.count, xor_filter_bits(keys.count, max_size));
+	free(keys.keys);
+	return filter;
 }
 
-SkipList m_get_non_vacc_list(M_VirusInfo info)
+BPTree m_get_vacc_list(M_VirusInfo info, int shard)
 {
-	return info->not_vaccinated_persons;
+	return info->vaccinated_persons[shard];
+}
+
+static void print_person(void * data, void * arg)
+{
+	m_citizen_info_print(data);
 }
 
 void m_virus_info_print(M_VirusInfo info)
 {
 	printf("%s\n", info->virus_name);
-	printf("Vaccinated People skip list:\n\n");
-	skip_list_print(info->vaccinated_persons);
-	printf("Not Vaccinated People skip list:\n\n");
-	skip_list_print(info->not_vaccinated_persons);
+	printf("Vaccinated People:\n\n");
+	for (int i = 0; i < info->shards; ++i)
+		bptree_traverse(info->vaccinated_persons[i], print_person, NULL);
+	printf("\n\n");
 }
 
 /*_______________________________________________________________*/
@@ -201,6 +361,11 @@ void * m_country_search_file(M_CountryInfo info, char * file_name)
 	return list_search(info->read_files, file_name);
 }
 
+List m_get_read_files(M_CountryInfo info)
+{
+	return info->read_files;
+}
+
 char * m_get_country_name(M_CountryInfo info)
 {
 	return info->country_name;
@@ -208,7 +373,7 @@ char * m_get_country_name(M_CountryInfo info)
 
 void m_country_population_inc(M_CountryInfo info)
 {
-	info->population++;
+	__atomic_add_fetch(&info->population, 1, __ATOMIC_RELAXED);		// the citizens of a country may be created by more threads (see m_ingest.c)
 }
 
 unsigned long m_country_population(M_CountryInfo info)
@@ -1,29 +1,56 @@
 /* file : m_items.h (monitor items) */
 #pragma once
 #include "bloom.h"
-#include "skip_list.h"
+#include <stdint.h>
+#include "bptree.h"
+#include "xor_filter.h"
+#include "arena.h"
+#include "intern.h"
+#include "list.h"
 
 typedef struct m_citizen_info * M_CitizenInfo;
 typedef struct m_virus_info * M_VirusInfo;
 typedef struct m_country_info * M_CountryInfo;
 
-M_CitizenInfo m_citizen_info_create(char * id, char * name, char * surname, int age, M_CountryInfo country);
+// the citizen and its id are allocated from arena, and its name and surname are interned in names, they are all deleted with the arena
+M_CitizenInfo m_citizen_info_create(Arena arena, Intern names, char * id, uint64_t key, char * name, char * surname, int age, M_CountryInfo country);
+// deletes what the citizen keeps out of the arena (its vaccination records)
 void m_citizen_info_destroy(M_CitizenInfo info);
 char * m_get_citizen_id(M_CitizenInfo info);
+uint64_t m_get_citizen_key(M_CitizenInfo info);
 char * m_get_citizen_name(M_CitizenInfo info);
 char * m_get_citizen_surname(M_CitizenInfo info);
 char * m_get_citizen_country(M_CitizenInfo info);
+M_CountryInfo m_get_citizen_country_info(M_CitizenInfo info);
 int m_get_citizen_age(M_CitizenInfo info);
+// returns the shard of the citizen with given id (0 <= shard < shards) : the records of a citizen are inserted by the thread of its shard,
+// and the citizen is kept in the tree of its shard of each virus (see m_ingest.h)
+int m_citizen_shard(char * id, int shards);
+// searches the vaccination records of citizen for the virus with given id, returns false if there is none
+// otherwise returns if citizen was vaccinated, and the date of vaccination (a day number, DATE_NONE if not vaccinated)
+bool m_citizen_find_record(M_CitizenInfo info, int virus_id, bool * vaccinated, unsigned int * date);
+// records that citizen was vaccinated (or not) against the virus with given id, replacing the previous record for this virus if any
+void m_citizen_set_record(M_CitizenInfo info, int virus_id, bool vaccinated, unsigned int date);
+// returns the number of vaccination records of citizen (one per virus)
+int m_citizen_records(M_CitizenInfo info);
+// returns the i-th vaccination record of citizen (0 <= i < m_citizen_records), in the order they were recorded
+void m_citizen_get_record(M_CitizenInfo info, int i, int * virus_id, bool * vaccinated, unsigned int * date);
 void m_citizen_info_print(M_CitizenInfo info);
 
 /*____________________________________________________________________________________________________*/
 
-M_VirusInfo m_virus_info_create(char * virus_name, unsigned int bloom_size, int max_level, float p);
+// the virus keeps a tree of vaccinated persons for each of the given number of shards
+M_VirusInfo m_virus_info_create(char * virus_name, int id, unsigned int bloom_size, unsigned int hashes, unsigned int options, int shards);
 void m_virus_info_destroy(M_VirusInfo info);
 char * m_get_virus_name(M_VirusInfo info);
+int m_get_virus_id(M_VirusInfo info);
 Bloom m_get_bloom_filter(M_VirusInfo info);
-SkipList m_get_vacc_list(M_VirusInfo info);
-SkipList m_get_non_vacc_list(M_VirusInfo info);
+bool m_bloom_changed(M_VirusInfo info);
+bool m_bloom_was_sent(M_VirusInfo info);
+void m_bloom_sent(M_VirusInfo info);
+XorFilter m_build_xor_filter(M_VirusInfo info, unsigned int max_size);
+// returns the tree of the vaccinated persons of virus, of given shard
+BPTree m_get_vacc_list(M_VirusInfo info, int shard);
 void m_virus_info_print(M_VirusInfo info);
 
 /*_____________________________________________________________________________________________________*/
@@ -32,6 +59,8 @@ M_CountryInfo m_country_info_create(char * country_name);
 void m_country_info_destroy(M_CountryInfo info);
 void m_country_add_file(M_CountryInfo info, char * file_name);
 void * m_country_search_file(M_CountryInfo info, char * file_name);
+// returns the list of the names of the files of the country that have been read
+List m_get_read_files(M_CountryInfo info);
 char * m_get_country_name(M_CountryInfo info);
 void m_country_population_inc(M_CountryInfo info);
 unsigned long m_country_population(M_CountryInfo info);
@@ -0,0 +1,420 @@
+/* file : m_snapshot.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "m_snapshot.h"
+#include "m_helper.h"
+#include "m_items.h"
+#include "id_index.h"
+#include "list.h"
+#include "bloom.h"
+#include "bptree.h"
+
+/* layout of a snapshot (integers in the byte order of the machine, strings as <uint32 length, with the '\0'> <chars> <'\0'>) :     */
+/* header    : <char magic[8]> <uint64 size of the file> <uint32 bloom_size> <uint32 hashes> <uint32 options>                     */
+/*             <uint32 subdirs> <uint32 countries> <uint32 viruses> <uint64 citizens>                                               */
+/* subdirs   : <string subdir> for each subdirectory assigned to the Monitor                                                        */
+/* countries : <string name> <uint32 files> <string file name> for each file read                                                  */
+/* viruses   : <string name> <uint32 generation> <uint32 bits> <bit array (bits / 8 bytes)> <uint8 counting> [<counters (bits bytes)>] */
+/*             in the order of their ids                                                                                            */
+/* citizens  : <string id> <uint64 key> <string name> <string surname> <int32 age> <uint32 country (index among the countries)>      */
+/*             <uint32 records> <uint16 virus id> <uint8 vaccinated> <uint32 date> for each vaccination record                       */
+
+/*========================== WRITING ==========================*/
+
+static void put(FILE * file, const void * data, size_t size)
+{
+	fwrite(data, 1, size, file);		// errors are checked once, at the end
+}
+
+static void put_u32(FILE * file, uint32_t value)
+{
+	put(file, &value, sizeof(value));
+}
+
+static void put_u64(FILE * file, uint64_t value)
+{
+	put(file, &value, sizeof(value));
+}
+
+static void put_string(FILE * file, const char * str)
+{
+	uint32_t length = strlen(str) + 1;
+	put_u32(file, length);
+	put(file, str, length);
+}
+
+static int compare_pointers(const void * a, const void * b)
+{
+	uintptr_t x = (uintptr_t) *(void * const *) a, y = (uintptr_t) *(void * const *) b;
+	return (x > y) - (x < y);
+}
+
+struct citizens_writer {		// what write_citizen needs
+	FILE * file;
+	M_CountryInfo * countries;	// the countries in the order they were written
+	uint32_t * order;			// positions of the countries of by_address in countries
+	M_CountryInfo * by_address;	// the countries sorted by address, to find the index of the country of a citizen
+	int num_countries;
+};
+
+static void write_citizen(void * value, void * arg)
+{
+	M_CitizenInfo citizen = value;
+	struct citizens_writer * writer = arg;
+
+	M_CountryInfo country = m_get_citizen_country_info(citizen);
+	M_CountryInfo * found = bsearch(&country, writer->by_address, writer->num_countries, sizeof(M_CountryInfo), compare_pointers);
+	assert(found != NULL);
+
+	put_string(writer->file, m_get_citizen_id(citizen));
+	put_u64(writer->file, m_get_citizen_key(citizen));
+	put_string(writer->file, m_get_citizen_name(citizen));
+	put_string(writer->file, m_get_citizen_surname(citizen));
+	int32_t age = m_get_citizen_age(citizen);
+	put(writer->file, &age, sizeof(age));
+	put_u32(writer->file, writer->order[found - writer->by_address]);
+
+	put_u32(writer->file, m_citizen_records(citizen));
+	for (int i = 0; i < m_citizen_records(citizen); ++i)
+	{
+		int virus_id;
+		bool vaccinated;
+		unsigned int date;
+		m_citizen_get_record(citizen, i, &virus_id, &vaccinated, &date);
+		uint16_t id = virus_id;
+		uint8_t vacc = vaccinated;
+		put(writer->file, &id, sizeof(id));
+		put(writer->file, &vacc, sizeof(vacc));
+		put_u32(writer->file, date);
+	}
+}
+
+int m_snapshot_save(struct Monitor * monitor)
+{
+	if (monitor->snapshot_path == NULL)
+		return 0;
+
+	char * tmp_path = malloc(strlen(monitor->snapshot_path) + 5);
+	if (tmp_path == NULL)
+		fprintf(stderr, "Error : m_snapshot_save -> malloc\n");
+	assert(tmp_path != NULL);
+	sprintf(tmp_path, "%s.tmp", monitor->snapshot_path);
+
+	FILE * file = fopen(tmp_path, "wb");
+	if (file == NULL)
+	{
+		perror("[Error] : m_snapshot_save -> fopen\n");
+		free(tmp_path);
+		return -1;
+	}
+	setvbuf(file, NULL, _IOFBF, SNAPSHOT_BUFFER_SIZE);
+
+	int num_countries = hash_size(monitor->countries_info);
+	int num_viruses = hash_size(monitor->viruses_info);
+	struct citizens_writer writer;
+	writer.file = file;
+	writer.num_countries = num_countries;
+	writer.countries = malloc((num_countries + 1) * sizeof(M_CountryInfo));
+	writer.by_address = malloc((num_countries + 1) * sizeof(M_CountryInfo));
+	writer.order = malloc((num_countries + 1) * sizeof(uint32_t));
+	if (writer.countries == NULL || writer.by_address == NULL || writer.order == NULL)
+		fprintf(stderr, "Error : m_snapshot_save -> malloc\n");
+	assert(writer.countries != NULL && writer.by_address != NULL && writer.order != NULL);
+
+	// header (the size of the file is filled in at the end)
+	char magic[8] = SNAPSHOT_MAGIC;
+	put(file, magic, sizeof(magic));
+	put_u64(file, 0);
+	put_u32(file, monitor->bloom_size);
+	put_u32(file, monitor->hashes);
+	put_u32(file, monitor->options);
+	put_u32(file, monitor->num_subdirs);
+	put_u32(file, num_countries);
+	put_u32(file, num_viruses);
+	put_u64(file, id_index_size(monitor->citizens_info));
+
+	for (int i = 0; i < monitor->num_subdirs; ++i)
+		put_string(file, monitor->subdirs[i]);
+
+	struct hash_cursor cursor;
+	M_CountryInfo country;
+	int c = 0;
+	hash_cursor_init(monitor->countries_info, &cursor);
+	while ((country = hash_cursor_next(&cursor)) != NULL)
+	{
+		writer.countries[c++] = country;
+		put_string(file, m_get_country_name(country));
+		List files = m_get_read_files(country);
+		put_u32(file, list_size(files));
+		for (ListNode node = list_first(files); node != NULL; node = list_next(files, node))
+			put_string(file, list_value(files, node));
+	}
+	memcpy(writer.by_address, writer.countries, num_countries * sizeof(M_CountryInfo));
+	qsort(writer.by_address, num_countries, sizeof(M_CountryInfo), compare_pointers);
+	for (int i = 0; i < num_countries; ++i)
+	{
+		M_CountryInfo * found = bsearch(&writer.countries[i], writer.by_address, num_countries, sizeof(M_CountryInfo), compare_pointers);
+		writer.order[found - writer.by_address] = i;
+	}
+
+	for (int id = 0; id < num_viruses; ++id)
+	{
+		M_VirusInfo virus = monitor->viruses_by_id[id];
+		Bloom bloom = m_get_bloom_filter(virus);
+		put_string(file, m_get_virus_name(virus));
+		put_u32(file, bloom->generation);
+		put_u32(file, bloom->size);
+		put(file, bloom->bit_array, bloom->size / 8);
+		uint8_t counting = (bloom->counters != NULL);
+		put(file, &counting, sizeof(counting));
+		if (counting)
+			put(file, bloom->counters, bloom->size);
+	}
+
+	id_index_traverse(monitor->citizens_info, write_citizen, &writer);
+
+	uint64_t size = ftell(file);
+	fseek(file, sizeof(magic), SEEK_SET);
+	put_u64(file, size);
+
+	int result = 0;
+	bool failed = ferror(file);
+	if (fclose(file) != 0)
+		failed = true;
+	if (failed)
+	{
+		perror("[Error] : m_snapshot_save -> could not write snapshot\n");
+		unlink(tmp_path);
+		result = -1;
+	}
+	else if (rename(tmp_path, monitor->snapshot_path) < 0)		// the new snapshot replaces the old one at once
+	{
+		perror("[Error] : m_snapshot_save -> rename\n");
+		unlink(tmp_path);
+		result = -1;
+	}
+
+	free(writer.countries);
+	free(writer.by_address);
+	free(writer.order);
+	free(tmp_path);
+	return result;
+}
+
+
+/*========================== READING ==========================*/
+
+struct reader {				// a snapshot mapped in memory
+	const char * data;
+	size_t size;
+	size_t pos;				// next byte to read
+	bool failed;			// true if a read went past the end (or found a malformed string)
+};
+
+static const void * get(struct reader * r, size_t size)
+{
+	if (r->failed || size > r->size - r->pos)
+	{
+		r->failed = true;
+		return NULL;
+	}
+	const void * data = r->data + r->pos;
+	r->pos += size;
+	return data;
+}
+
+static uint32_t get_u32(struct reader * r)
+{
+	uint32_t value = 0;
+	const void * data = get(r, sizeof(value));
+	if (data != NULL)
+		memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static uint64_t get_u64(struct reader * r)
+{
+	uint64_t value = 0;
+	const void * data = get(r, sizeof(value));
+	if (data != NULL)
+		memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+// returns the string at the current position, in place (it ends with its '\0'), or "" if it is malformed
+static char * get_string(struct reader * r)
+{
+	uint32_t length = get_u32(r);
+	const char * str = get(r, length);
+	if (str == NULL || length == 0 || str[length - 1] != '\0')
+	{
+		r->failed = true;
+		return "";
+	}
+	return (char *) str;
+}
+
+// true if the subdirectories of the snapshot are the ones assigned to monitor (in any order)
+static bool same_subdirs(struct Monitor * monitor, struct reader * r, uint32_t count)
+{
+	if (count != monitor->num_subdirs)
+		return false;
+	bool same = true;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		char * subdir = get_string(r);
+		bool found = false;
+		for (int j = 0; j < monitor->num_subdirs && !found; ++j)
+			found = !strcmp(subdir, monitor->subdirs[j]);
+		same = same && found;
+	}
+	return same && !r->failed;
+}
+
+// rebuilds the state of monitor from the snapshot, after its header and subdirectories, returns false if the snapshot is corrupt
+static bool load_state(struct Monitor * monitor, struct reader * r, uint32_t num_countries, uint32_t num_viruses, uint64_t num_citizens)
+{
+	M_CountryInfo * countries = malloc((num_countries + 1) * sizeof(M_CountryInfo));
+	if (countries == NULL)
+		fprintf(stderr, "Error : load_state -> malloc\n");
+	assert(countries != NULL);
+
+	for (uint32_t c = 0; c < num_countries && !r->failed; ++c)
+	{
+		countries[c] = m_country_info_create(get_string(r));
+		hash_insert(monitor->countries_info, countries[c]);
+		uint32_t files = get_u32(r);
+		for (uint32_t f = 0; f < files && !r->failed; ++f)
+			m_country_add_file(countries[c], get_string(r));
+	}
+
+	for (uint32_t id = 0; id < num_viruses && !r->failed; ++id)
+	{
+		M_VirusInfo virus = Monitor_add_virus(monitor, get_string(r));
+		Bloom bloom = m_get_bloom_filter(virus);
+		unsigned int generation = get_u32(r);
+		if (get_u32(r) != bloom->size)
+			r->failed = true;
+		const void * bit_array = get(r, bloom->size / 8);
+		const uint8_t * counting = get(r, sizeof(uint8_t));
+		if (r->failed || (*counting != 0) != (bloom->counters != NULL))
+		{
+			r->failed = true;
+			break;
+		}
+		memcpy(bloom->bit_array, bit_array, bloom->size / 8);
+		if (*counting)
+		{
+			const void * counters = get(r, bloom->size);
+			if (counters != NULL)
+				memcpy(bloom->counters, counters, bloom->size);
+		}
+		bloom->generation = generation;
+	}
+
+	for (uint64_t i = 0; i < num_citizens && !r->failed; ++i)
+	{
+		char * id = get_string(r);
+		uint64_t key = get_u64(r);
+		char * name = get_string(r);
+		char * surname = get_string(r);
+		int32_t age = 0;
+		const void * data = get(r, sizeof(age));
+		if (data != NULL)
+			memcpy(&age, data, sizeof(age));
+		uint32_t country = get_u32(r);
+		uint32_t records = get_u32(r);
+		if (r->failed || country >= num_countries)
+		{
+			r->failed = true;
+			break;
+		}
+
+		M_CitizenInfo citizen = m_citizen_info_create(monitor->citizens_arena, monitor->names, id, key, name, surname, age, countries[country]);
+		id_index_insert(monitor->citizens_info, citizen);
+		id_index_claim_key(monitor->citizens_info, key);
+		int shard = m_citizen_shard(id, monitor->threads);
+		for (uint32_t j = 0; j < records && !r->failed; ++j)
+		{
+			uint16_t virus_id = 0;
+			const void * id_data = get(r, sizeof(virus_id));
+			const uint8_t * vaccinated = get(r, sizeof(uint8_t));
+			uint32_t date = get_u32(r);
+			if (r->failed)
+				break;
+			memcpy(&virus_id, id_data, sizeof(virus_id));
+			if (virus_id >= num_viruses)
+			{
+				r->failed = true;
+				break;
+			}
+			M_VirusInfo virus = monitor->viruses_by_id[virus_id];
+			if (*vaccinated)
+				bptree_insert(m_get_vacc_list(virus, shard), key, citizen);
+			m_citizen_set_record(citizen, virus_id, *vaccinated, date);
+		}
+	}
+
+	free(countries);
+	return !r->failed && r->pos == r->size;
+}
+
+int m_snapshot_load(struct Monitor * monitor)
+{
+	if (monitor->snapshot_path == NULL)
+		return 1;
+	int fd = open(monitor->snapshot_path, O_RDONLY);
+	if (fd < 0)
+		return 1;		// no snapshot
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size == 0)
+	{
+		close(fd);
+		return 1;
+	}
+	void * data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		perror("[Error] : m_snapshot_load -> mmap\n");
+		return 1;
+	}
+	madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+	struct reader r = { data, st.st_size, 0, false };
+	const char * magic = get(&r, 8);
+	uint64_t size = get_u64(&r);
+	uint32_t bloom_size = get_u32(&r);
+	uint32_t hashes = get_u32(&r);
+	uint32_t options = get_u32(&r);
+	uint32_t num_subdirs = get_u32(&r);
+	uint32_t num_countries = get_u32(&r);
+	uint32_t num_viruses = get_u32(&r);
+	uint64_t num_citizens = get_u64(&r);
+
+	// a snapshot of a Monitor with other settings or subdirectories (e.g. left over by another run) is not used
+	if (r.failed || memcmp(magic, SNAPSHOT_MAGIC, 8) != 0 || size != r.size || bloom_size != monitor->bloom_size || hashes != monitor->hashes
+		|| options != monitor->options || !same_subdirs(monitor, &r, num_subdirs))
+	{
+		munmap(data, st.st_size);
+		return 1;
+	}
+
+	int result = 0;
+	if (!load_state(monitor, &r, num_countries, num_viruses, num_citizens))
+	{
+		fprintf(stderr, "[Error] : m_snapshot_load -> snapshot %s is corrupt, it is deleted\n\n", monitor->snapshot_path);
+		unlink(monitor->snapshot_path);		// so that the next Monitor does not try it again
+		result = -1;
+	}
+	munmap(data, st.st_size);		// the strings used in place are all copied (or interned) by now
+	return result;
+}
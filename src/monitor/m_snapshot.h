@@ -0,0 +1,19 @@
+/* file : m_snapshot.h */
+/* binary snapshot of the state of a Monitor (its countries and the files read, its viruses and their filters, its citizens and their */
+/* vaccination records), so that a Monitor that replaces one that was terminated starts from it, instead of reading every file again */
+/* the snapshot is written after the files are read (at start, and on every update), to a temporary file that is then renamed over the */
+/* old one, so there is always a whole snapshot.  It is loaded by mapping the file and building the state again from it : the strings */
+/* are copied (or interned) into new citizens, countries and viruses, the bit arrays are copied as they are, and the trees of the */
+/* viruses are built again by inserting each vaccination record, so a load costs O(records), but no file has to be parsed */
+#pragma once
+#include "m_helper.h"
+
+#define SNAPSHOT_MAGIC "MSNAP01"				// first bytes of a snapshot (with the '\0'), the version of the format is in it
+#define SNAPSHOT_BUFFER_SIZE (1 << 20)			// size of the buffer of the snapshot file while it is written
+
+/* writes the snapshot of monitor to monitor->snapshot_path (if it is not NULL), returns 0 on success, -1 if it could not be written */
+int m_snapshot_save(struct Monitor * monitor);
+/* loads the snapshot at monitor->snapshot_path into monitor (that must be empty), if it was taken by a Monitor with the same settings */
+/* and subdirectories, returns 0 if it was loaded, 1 if there is no such snapshot (monitor is left empty), -1 if the snapshot is corrupt */
+/* (it is deleted, and the part of it already loaded is left in monitor, to be thrown away by the caller, see read_subdirs) */
+int m_snapshot_load(struct Monitor * monitor);
@@ -0,0 +1,130 @@
+/*file : arena.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "arena.h"
+#include <assert.h>
+
+// a block of an arena, the blocks are linked from the newest to the oldest
+struct arena_block {
+	struct arena_block * next;
+	char data[];
+};
+
+// data struct for arena
+struct arena {
+	struct arena_block * blocks;
+	char * top;				// next free byte of the newest block
+	char * end;				// end of the newest block
+	size_t used;			// bytes allocated so far
+};
+
+Arena arena_create(void)
+{
+	Arena arena = malloc(sizeof(struct arena));
+	if (arena == NULL)
+		fprintf(stderr, "Error : arena_create -> malloc\n");
+	assert(arena != NULL);
+
+	arena->blocks = NULL;
+	arena->top = NULL;
+	arena->end = NULL;
+	arena->used = 0;
+	return arena;
+}
+
+// adds a block of given size to the arena, and returns its memory
+static char * add_block(Arena arena, size_t size)
+{
+	struct arena_block * block = malloc(sizeof(struct arena_block) + size);
+	if (block == NULL)
+		fprintf(stderr, "Error : add_block -> malloc\n");
+	assert(block != NULL);
+
+	block->next = arena->blocks;
+	arena->blocks = block;
+	return block->data;
+}
+
+void * arena_alloc(Arena arena, size_t size)
+{
+	if (arena == NULL)
+		fprintf(stderr, "Error : arena_alloc -> arena is NULL\n");
+	assert(arena != NULL);
+
+	size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	arena->used += size;
+	if (size > (size_t) (arena->end - arena->top))
+	{
+		if (size > ARENA_BLOCK_SIZE / 4)		// a large object gets a block of its own, so that the rest of the newest block is not lost
+		{
+			char * data = add_block(arena, size);
+			if (arena->top != NULL)		// the newest block stays the one with free space
+			{
+				struct arena_block * block = arena->blocks;
+				arena->blocks = block->next;
+				block->next = arena->blocks->next;
+				arena->blocks->next = block;
+			}
+			return data;
+		}
+		arena->top = add_block(arena, ARENA_BLOCK_SIZE);
+		arena->end = arena->top + ARENA_BLOCK_SIZE;
+	}
+
+	void * memory = arena->top;
+	arena->top += size;
+	return memory;
+}
+
+char * arena_strdup(Arena arena, const char * str)
+{
+	size_t length = strlen(str) + 1;
+	char * copy = arena_alloc(arena, length);
+	memcpy(copy, str, length);
+	return copy;
+}
+
+void arena_merge(Arena arena, Arena other)
+{
+	if (arena == NULL || other == NULL)
+		fprintf(stderr, "Error : arena_merge -> arena is NULL\n");
+	assert(arena != NULL && other != NULL);
+
+	if (arena->blocks == NULL)		// the newest block of other becomes the newest one of arena
+	{
+		arena->blocks = other->blocks;
+		arena->top = other->top;
+		arena->end = other->end;
+	}
+	else if (other->blocks != NULL)		// the blocks of other go right after the newest block of arena, which keeps its free space
+	{
+		struct arena_block * last = other->blocks;
+		while (last->next != NULL)
+			last = last->next;
+		last->next = arena->blocks->next;
+		arena->blocks->next = other->blocks;
+	}
+	arena->used += other->used;
+	free(other);
+}
+
+size_t arena_used(Arena arena)
+{
+	return arena->used;
+}
+
+void arena_destroy(Arena arena)
+{
+	if (arena == NULL)
+		fprintf(stderr, "Error : arena_destroy -> arena is NULL\n");
+	assert(arena != NULL);
+
+	while (arena->blocks != NULL)
+	{
+		struct arena_block * block = arena->blocks;
+		arena->blocks = block->next;
+		free(block);
+	}
+	free(arena);
+}
@@ -0,0 +1,24 @@
+/*file : arena.h*/
+#pragma once
+#include <stddef.h>
+
+/* arena : memory for many small objects that live as long as the arena (e.g. the citizens of a Monitor), each one is allocated by */
+/* moving a pointer forward in a large block, without a header or a call to malloc, and they are all freed at once with the arena */
+
+#define ARENA_BLOCK_SIZE (64 * 1024)	// size of the blocks of an arena (a larger object gets a block of its own)
+#define ARENA_ALIGN 8					// alignment of the objects of an arena
+
+typedef struct arena * Arena;
+
+/* creates an empty arena */
+Arena arena_create(void);
+/* returns size bytes of memory from the arena, aligned to ARENA_ALIGN */
+void * arena_alloc(Arena arena, size_t size);
+/* returns a copy of given string, in the arena */
+char * arena_strdup(Arena arena, const char * str);
+/* moves the objects of arena other into arena (they are freed with it from now on), and deletes other */
+void arena_merge(Arena arena, Arena other);
+/* returns the number of bytes allocated from the arena so far */
+size_t arena_used(Arena arena);
+/* deletes the arena, and every object allocated from it */
+void arena_destroy(Arena arena);
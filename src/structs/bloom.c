@@ -1,74 +1,230 @@
 /*file : bloom.c*/
+#define _GNU_SOURCE		// for memfd_create
 #include <stdlib.h>
 #include <stdio.h>
 #include "bloom.h"
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <math.h>
 
-/* first hash function : djb2*/
-unsigned long djb2(unsigned char *str) {
-	unsigned long hash = 5381;
-	int c; 
-	while ((c = *str++)) {
-		hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-	}
-	return hash;
+/* final mix of murmur3 (fmix64), every bit of x affects every bit of the result */
+static inline uint64_t mix64(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
 }
 
-/* second hash function : sdbm*/
-unsigned long sdbm(unsigned char *str) {
-	unsigned long hash = 0;
-	int c;
+uint64_t bloom_hash(unsigned char * string)
+{
+	// numeric strings of up to 16 digits are hashed by their value (and number of digits, so that "007" and "7" differ)
+	uint64_t value = 0;
+	unsigned char * s = string;
+	for (; *s >= '0' && *s <= '9' && s - string < 16; s++)
+		value = value * 10 + (*s - '0');
+	if (*s == '\0' && s != string)
+		return mix64((value << 5) | (s - string));
 
-	while ((c = *str++)) {
-		hash = c + (hash << 6) + (hash << 16) - hash;
+	uint64_t hash = 0xcbf29ce484222325ULL;		// FNV-1a, for the rest of the strings
+	for (s = string; *s; s++)
+	{
+		hash ^= *s;
+		hash *= 0x100000001b3ULL;
+	}
+	return mix64(hash);
+}
+
+unsigned int bloom_optimal_k(unsigned int bloom_size, unsigned long expected, double fp_rate)
+{
+	double bits = (double) bloom_size * 8;
+	if (expected == 0)
+		expected = 1;
+	unsigned int best_k = 1;
+	double best_rate = 1.0;
+	for (unsigned int k = 1; k <= BLOOM_MAX_K; k++)
+	{
+		double rate = pow(1 - exp(-(double) k * expected / bits), k);	// false positive rate with k hash functions
+		if (rate <= fp_rate)
+			return k;
+		if (rate < best_rate)
+		{
+			best_rate = rate;
+			best_k = k;
+		}
 	}
+	return best_k;
+}
 
-	return hash;
+// private bit arrays are allocated in whole cache lines and aligned to them, so that a block of a blocked bloom filter is exactly one
+// cache line, and so that bloom_check_many can read the last bytes as a 32-bit word (the padding is always zero, mapped bit arrays are
+// aligned to pages, and padded by the rest of their last page)
+#define CACHE_LINE 64
+static uint8_t * bit_array_alloc(unsigned int bloom_size)
+{
+	size_t size = (bloom_size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+	if (size == 0)
+		size = CACHE_LINE;
+	uint8_t * bit_array = aligned_alloc(CACHE_LINE, size);
+	if (bit_array != NULL)
+		memset(bit_array, 0, size);
+	return bit_array;
 }
 
- 
-/* Return the result of the Kth hash function. This function uses djb2 and sdbm. */
-unsigned long hash_i(unsigned char *str, unsigned int i) {
-	return djb2(str) + i*sdbm(str) + i*i;
+// a blocked layout needs room for at least one block, and a bit array aligned to cache lines (so that no block straddles two of them)
+static void set_layout(Bloom bloom, bool blocked)
+{
+	bloom->blocks = bloom->size / BLOOM_BLOCK_BITS;
+	bloom->blocked = blocked && bloom->blocks > 0;
+	if (bloom->blocked && (uintptr_t) bloom->bit_array % CACHE_LINE != 0)
+		fprintf(stderr, "Error : set_layout -> bit array of blocked bloom filter is not aligned to cache lines\n");
+	assert(!bloom->blocked || (uintptr_t) bloom->bit_array % CACHE_LINE == 0);
+}
+
+/* the k probes of a hash are h1 + i * h2 (double hashing) */
+/* in a plain bloom filter, h1 and h2 are the two halves of the hash, and a probe is mapped to a bit of the filter with a multiply */
+/* instead of a modulo. In a blocked bloom filter, the high half of the hash chooses the block (base is its first bit), and the */
+/* probes are taken from the rest of the bits of the hash, the top bits of a probe are the bit in the block */
+static inline void probes_init(Bloom bloom, uint64_t hash, unsigned long * base, uint32_t * h1, uint32_t * h2)
+{
+	if (bloom->blocked)
+	{
+		*base = (((hash >> 32) * bloom->blocks) >> 32) * BLOOM_BLOCK_BITS;
+		*h1 = hash;
+		*h2 = (uint32_t) ((hash * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+	}
+	else
+	{
+		*base = 0;
+		*h1 = hash;
+		*h2 = (hash >> 32) | 1;
+	}
 }
 
+static inline unsigned long probe_pos(Bloom bloom, unsigned long base, uint32_t probe)
+{
+	if (bloom->blocked)
+		return base + (((uint64_t) probe * BLOOM_BLOCK_BITS) >> 32);		// the top bits, a bit of the block
+	return ((uint64_t) probe * bloom->size) >> 32;
+}
 
-Bloom bloom_create(unsigned int bloom_size)
+Bloom bloom_create(unsigned int bloom_size, unsigned int k, bool blocked)
 {
 	Bloom bloom = malloc(sizeof(*bloom));	// malloc bloom pointer to the bloom filter structure
 	if (bloom == NULL)
 		fprintf(stderr, "Error : bloom_create -> malloc\n");
 	assert(bloom != NULL);
 
-	bloom->bit_array = malloc(bloom_size * sizeof(uint8_t));	// malloc the bit array to have bloom_size 8-bit integers so total of 8*bloom_size bits
+	// the bit array has bloom_size 8-bit integers so total of 8*bloom_size bits, initially all bits and hence all bytes of bit array are zero
+	bloom->bit_array = bit_array_alloc(bloom_size);
 	if (bloom->bit_array == NULL)
-		fprintf(stderr, "Error : bloom_create -> malloc\n");
+		fprintf(stderr, "Error : bloom_create -> aligned_alloc\n");
 	assert(bloom->bit_array != NULL);
 
-	for (unsigned int i = 0; i < bloom_size; i++)
-		bloom->bit_array[i] = 0;		// initially all bits and hence all bytes of bit array are set to zero
-
 	bloom->size = bloom_size * 8;	// keep the number of bits of the bloom filter
+	bloom->shm_fd = -1;
+	bloom->shared = false;
+	bloom->k = k;
+	set_layout(bloom, blocked);
+	bloom->generation = 0;
+	bloom->dirty = NULL;
+	bloom->dirty_words = 0;
+	bloom->counters = NULL;
 
 	return bloom;
 
 }
 
-Bloom bloom_copy_create(unsigned int bloom_size, void * bit_array)
+Bloom bloom_create_shared(unsigned int bloom_size, unsigned int k, bool blocked)
+{
+	int shm_fd = memfd_create("bloom", MFD_CLOEXEC);		// an anonymous segment, that goes away with the last fd/mapping that refers to it
+	if (shm_fd < 0)
+		return NULL;
+	if (ftruncate(shm_fd, bloom_size * sizeof(uint8_t)) < 0)	// a new segment is all zeros, so initially all bits are zero
+	{
+		close(shm_fd);
+		return NULL;
+	}
+	void * bit_array = mmap(NULL, bloom_size * sizeof(uint8_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+	if (bit_array == MAP_FAILED)
+	{
+		close(shm_fd);
+		return NULL;
+	}
+
+	Bloom bloom = malloc(sizeof(*bloom));	// malloc bloom pointer to the bloom filter structure
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_create_shared -> malloc\n");
+	assert(bloom != NULL);
+
+	bloom->bit_array = bit_array;
+	bloom->size = bloom_size * 8;
+	bloom->shm_fd = shm_fd;			// kept open, so that other processes can reach the segment
+	bloom->shared = true;
+	bloom->k = k;
+	set_layout(bloom, blocked);
+	bloom->generation = 0;
+	bloom->dirty = NULL;
+	bloom->dirty_words = 0;
+	bloom->counters = NULL;
+	return bloom;
+}
+
+Bloom bloom_attach(unsigned int bloom_size, unsigned int k, bool blocked, const char * path)
+{
+	int shm_fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (shm_fd < 0)
+		return NULL;
+	void * bit_array = mmap(NULL, bloom_size * sizeof(uint8_t), PROT_READ, MAP_SHARED, shm_fd, 0);
+	close(shm_fd);		// the mapping keeps the segment alive
+	if (bit_array == MAP_FAILED)
+		return NULL;
+
+	Bloom bloom = malloc(sizeof(*bloom));	// malloc bloom pointer to the bloom filter structure
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_attach -> malloc\n");
+	assert(bloom != NULL);
+
+	bloom->bit_array = bit_array;	// read only, every insert of the owner is visible here right away
+	bloom->size = bloom_size * 8;
+	bloom->shm_fd = -1;
+	bloom->shared = true;
+	bloom->k = k;
+	set_layout(bloom, blocked);
+	bloom->generation = 0;
+	bloom->dirty = NULL;
+	bloom->dirty_words = 0;
+	bloom->counters = NULL;
+	return bloom;
+}
+
+Bloom bloom_copy_create(unsigned int bloom_size, unsigned int k, bool blocked, void * bit_array)
 {
 	Bloom bloom = malloc(sizeof(*bloom));	// malloc bloom pointer to the bloom filter structure
 	if (bloom == NULL)
 		fprintf(stderr, "Error : bloom_copy_create -> malloc\n");
 	assert(bloom != NULL);
 
-	bloom->bit_array = malloc(bloom_size * sizeof(uint8_t));	// malloc the bit array to have bloom_size 8-bit integers so total of 8*bloom_size bits
+	bloom->bit_array = bit_array_alloc(bloom_size);	// the bit array has bloom_size 8-bit integers so total of 8*bloom_size bits
 	if (bloom->bit_array == NULL)
-		fprintf(stderr, "Error : bloom_copy_create -> malloc\n");
+		fprintf(stderr, "Error : bloom_copy_create -> aligned_alloc\n");
 	assert(bloom->bit_array != NULL);
 	
 	memcpy(bloom->bit_array, bit_array, bloom_size * sizeof(uint8_t));	// copy the bit_array with the one given
 	bloom->size = bloom_size * 8;
+	bloom->shm_fd = -1;
+	bloom->shared = false;
+	bloom->k = k;
+	set_layout(bloom, blocked);
+	bloom->generation = 0;
+	bloom->dirty = NULL;
+	bloom->dirty_words = 0;
+	bloom->counters = NULL;
 	return bloom;
 }
 
@@ -77,28 +233,39 @@ void bloom_bit_array_copy(Bloom bloom, void * bit_array)
 	memcpy(bloom->bit_array, bit_array, ((bloom->size)/8) * sizeof(uint8_t));	// just copy the bit_array with the one given
 }
 
+// marks the word of the bit at given position as changed, if changes are tracked
+static void mark_dirty(Bloom bloom, unsigned long pos)
+{
+	if (bloom->dirty == NULL)
+		return;
+	unsigned long word = pos / (8 * BLOOM_WORD_SIZE);
+	uint64_t mask = (uint64_t) 1 << (word % 64);
+	if (!(bloom->dirty[word / 64] & mask))
+	{
+		bloom->dirty[word / 64] |= mask;
+		bloom->dirty_words++;
+	}
+}
+
 bool bloom_check(Bloom bloom, unsigned char * string)
 {
 	if (bloom == NULL)
 		fprintf(stderr, "Error : bloom_check -> bloom is NULL\n");
 	assert(bloom != NULL);
 
-	bool maybe_in = true;	// initially assume that the given object may be into the bloom filter (either positive or false positive)
-	for (int i = 0; i < K; i++)		// for all k hash functions
+	uint64_t hash = bloom_hash(string);		// the string is hashed once, for all k probes
+	unsigned long base; uint32_t h1, h2;
+	probes_init(bloom, hash, &base, &h1, &h2);
+	for (unsigned int i = 0; i < bloom->k; i++, h1 += h2)
 	{
-		unsigned long pos = hash_i(string, i) % bloom->size;	// get bit position in bit array as returned from hash function
-		// this following line isolates the 8-bit number where our bit of interest is found (pos/8)
-		// sets all other bits of the 8-bit number to zero. If the remaining number is zero that means the bit of interest (pos%8) is also zero. Otherwise it is 1
+		unsigned long pos = probe_pos(bloom, base, h1);	// get bit position in bit array as given by the probe
+		// isolate the 8-bit number where our bit of interest is found (pos/8), and the bit (pos%8) in it
 		if ((bloom->bit_array[pos/8] & (1 << (pos % 8))) == 0)
-		{							
-			maybe_in = false;	// bit indicated by current hash function is zero, that means that the given object definitely isn't in the bloom-filter
-			break;
-		}
+			return false;	// bit indicated by current probe is zero, that means that the given object definitely isn't in the bloom-filter
 	}
 
-	// if all the bits indicated by the hash-functions were 1, then right here maybe_in will be 1 as well
-
-	return maybe_in;
+	// all the bits indicated by the probes were 1, the object may be in the bloom filter (either positive or false positive)
+	return true;
 }
 
 void bloom_insert(Bloom bloom, unsigned char * string)
@@ -107,24 +274,291 @@ void bloom_insert(Bloom bloom, unsigned char * string)
 		fprintf(stderr, "Error : bloom_insert -> bloom is NULL\n");
 	assert(bloom != NULL);
 
-	for (int i = 0; i < K; i++)	// for all k hash functions
+	uint64_t hash = bloom_hash(string);		// the string is hashed once, for all k probes
+	unsigned long base; uint32_t h1, h2;
+	probes_init(bloom, hash, &base, &h1, &h2);
+	for (unsigned int i = 0; i < bloom->k; i++, h1 += h2)
 	{
-		unsigned long pos = hash_i(string, i) % bloom->size;	// get bit position in bit array as returned from hash function
+		unsigned long pos = probe_pos(bloom, base, h1);	// get bit position in bit array as given by the probe
 		// set bit at position by doing a bitwise or of the 8-bit number where our bit of interest is found
 		// with another 8-bit number which has 1 only at the position of our bit of interest
 		bloom->bit_array[pos/8]  = bloom->bit_array[pos/8] | (1 << (pos % 8));
-		
+		if (bloom->counters != NULL && bloom->counters[pos] < UINT8_MAX)
+			bloom->counters[pos]++;
+		mark_dirty(bloom, pos);
 	}
+	bloom->generation += 1;
 
 }
 
+void bloom_merge(Bloom bloom, Bloom other)
+{
+	if (bloom == NULL || other == NULL || bloom->size != other->size || bloom->k != other->k || bloom->blocked != other->blocked || bloom->counters != NULL)
+		fprintf(stderr, "Error : bloom_merge -> bloom filters do not match, or bloom is counting\n");
+	assert(bloom != NULL && other != NULL && bloom->size == other->size && bloom->k == other->k && bloom->blocked == other->blocked && bloom->counters == NULL);
+
+	for (unsigned int i = 0; i < bloom->size / 8; i++)
+	{
+		uint8_t added = other->bit_array[i] & ~bloom->bit_array[i];		// the bits set only by other
+		if (added != 0)
+		{
+			bloom->bit_array[i] |= added;
+			mark_dirty(bloom, (unsigned long) i * 8);
+		}
+	}
+	bloom->generation += other->generation;
+}
+
+void bloom_track_counts(Bloom bloom)
+{
+	if (bloom->counters != NULL)
+		return;
+	assert(bloom->generation == 0);		// counters of objects already inserted are unknown
+	bloom->counters = calloc(bloom->size, sizeof(uint8_t));
+	if (bloom->counters == NULL)
+		fprintf(stderr, "Error : bloom_track_counts -> calloc\n");
+	assert(bloom->counters != NULL);
+}
+
+bool bloom_remove(Bloom bloom, unsigned char * string)
+{
+	if (bloom == NULL || bloom->counters == NULL)
+		fprintf(stderr, "Error : bloom_remove -> bloom is NULL or not counting\n");
+	assert(bloom != NULL && bloom->counters != NULL);
+
+	if (!bloom_check(bloom, string))		// nothing to remove
+		return false;
+
+	uint64_t hash = bloom_hash(string);
+	unsigned long base; uint32_t h1, h2;
+	probes_init(bloom, hash, &base, &h1, &h2);
+	for (unsigned int i = 0; i < bloom->k; i++, h1 += h2)
+	{
+		unsigned long pos = probe_pos(bloom, base, h1);
+		if (bloom->counters[pos] == 0 || bloom->counters[pos] == UINT8_MAX)	// already cleared by a previous probe of the string, or saturated
+			continue;
+		if (--bloom->counters[pos] == 0)		// no object sets the bit anymore
+		{
+			bloom->bit_array[pos/8] &= ~(1 << (pos % 8));
+			mark_dirty(bloom, pos);
+		}
+	}
+	bloom->generation += 1;
+	return true;
+}
+
+/* bloom_check_many checks the strings in groups of BLOOM_GROUP, first the strings of a group are hashed and their */
+/* probes are prefetched, and then their probes are checked, either all strings of the group at once with AVX2, or one by one */
+#define BLOOM_GROUP 8
+
+struct probe_group {
+	unsigned long base[BLOOM_GROUP];		// the first bit of the block of each string (0 if not blocked)
+	uint32_t h1[BLOOM_GROUP];				// the first probe of each string
+	uint32_t h2[BLOOM_GROUP];				// the step between the probes of each string
+};
+
+static void group_init(Bloom bloom, unsigned char ** strings, unsigned int n, struct probe_group * group)
+{
+	for (unsigned int j = 0; j < n; j++)
+	{
+		probes_init(bloom, bloom_hash(strings[j]), &group->base[j], &group->h1[j], &group->h2[j]);
+		if (bloom->blocked)		// all probes are in one cache line
+			__builtin_prefetch(&bloom->bit_array[group->base[j] / 8]);
+		else
+		{
+			uint32_t h1 = group->h1[j];
+			for (unsigned int i = 0; i < bloom->k; i++, h1 += group->h2[j])
+				__builtin_prefetch(&bloom->bit_array[probe_pos(bloom, 0, h1) / 8]);
+		}
+	}
+}
+
+static void group_check_scalar(Bloom bloom, struct probe_group * group, unsigned int n, bool * maybe)
+{
+	for (unsigned int j = 0; j < n; j++)
+	{
+		maybe[j] = true;
+		uint32_t h1 = group->h1[j];
+		for (unsigned int i = 0; i < bloom->k; i++, h1 += group->h2[j])
+		{
+			unsigned long pos = probe_pos(bloom, group->base[j], h1);
+			if ((bloom->bit_array[pos/8] & (1 << (pos % 8))) == 0)
+			{
+				maybe[j] = false;
+				break;
+			}
+		}
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// the high 32 bits of the product of each 32-bit lane of a with b
+__attribute__((target("avx2")))
+static inline __m256i mulhi_epu32(__m256i a, __m256i b)
+{
+	__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32);		// products of lanes 0, 2, 4, 6 (high half moved to the low half)
+	__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);		// products of lanes 1, 3, 5, 7 (high half already in place)
+	return _mm256_blend_epi32(even, odd, 0xaa);
+}
+
+// checks the probes of a full group at once, one lane per string, the words of the bit array are gathered 32 bits at a time
+// (x86 is little endian, so bit pos of the bit array is bit pos % 32 of the 32-bit word pos / 32)
+__attribute__((target("avx2")))
+static void group_check_avx2(Bloom bloom, struct probe_group * group, bool * maybe)
+{
+	uint32_t base[BLOOM_GROUP];
+	for (int j = 0; j < BLOOM_GROUP; j++)
+		base[j] = group->base[j];
+	__m256i vbase = _mm256_loadu_si256((__m256i *) base);
+	__m256i h1 = _mm256_loadu_si256((__m256i *) group->h1);
+	__m256i h2 = _mm256_loadu_si256((__m256i *) group->h2);
+	__m256i range = _mm256_set1_epi32(bloom->blocked ? BLOOM_BLOCK_BITS : bloom->size);		// probes are mapped to [0, range) and then added to base
+	__m256i all = _mm256_set1_epi32(-1);
+	__m256i alive = all;		// lanes whose bits were all set so far
+	for (unsigned int i = 0; i < bloom->k; i++)
+	{
+		__m256i pos = _mm256_add_epi32(vbase, mulhi_epu32(h1, range));
+		__m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *) bloom->bit_array,
+													 _mm256_srli_epi32(pos, 5), alive, 4);
+		__m256i bits = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(pos, _mm256_set1_epi32(31))), _mm256_set1_epi32(1));
+		alive = _mm256_and_si256(alive, _mm256_cmpeq_epi32(bits, _mm256_set1_epi32(1)));
+		if (_mm256_testz_si256(alive, all))		// every string already got a zero bit
+			break;
+		h1 = _mm256_add_epi32(h1, h2);
+	}
+	int mask = _mm256_movemask_ps(_mm256_castsi256_ps(alive));
+	for (int j = 0; j < BLOOM_GROUP; j++)
+		maybe[j] = (mask >> j) & 1;
+}
+
+static bool have_avx2(void)
+{
+	static int avx2 = -1;		// checked once
+	if (avx2 < 0)
+	{
+		__builtin_cpu_init();
+		avx2 = __builtin_cpu_supports("avx2");
+	}
+	return avx2;
+}
+#endif
+
+void bloom_check_many(Bloom bloom, unsigned char ** strings, unsigned int n, bool * maybe)
+{
+	if (bloom == NULL)
+		fprintf(stderr, "Error : bloom_check_many -> bloom is NULL\n");
+	assert(bloom != NULL);
+
+	struct probe_group group;
+	for (unsigned int first = 0; first < n; first += BLOOM_GROUP)
+	{
+		unsigned int count = (n - first < BLOOM_GROUP) ? n - first : BLOOM_GROUP;
+		group_init(bloom, strings + first, count, &group);
+#if defined(__x86_64__) || defined(__i386__)
+		// 32-bit lanes, so the positions must fit in 32 bits
+		if (count == BLOOM_GROUP && have_avx2() && (uint64_t) bloom->size + BLOOM_BLOCK_BITS <= UINT32_MAX)
+		{
+			group_check_avx2(bloom, &group, maybe + first);
+			continue;
+		}
+#endif
+		group_check_scalar(bloom, &group, count, maybe + first);
+	}
+}
+
+unsigned int bloom_num_words(Bloom bloom)
+{
+	return (bloom->size / 8 + BLOOM_WORD_SIZE - 1) / BLOOM_WORD_SIZE;
+}
+
+void bloom_track_dirty(Bloom bloom)
+{
+	if (bloom->dirty != NULL)
+		return;
+	bloom->dirty = calloc((bloom_num_words(bloom) + 63) / 64, sizeof(uint64_t));	// one bit per word
+	if (bloom->dirty == NULL)
+		fprintf(stderr, "Error : bloom_track_dirty -> calloc\n");
+	assert(bloom->dirty != NULL);
+	bloom->dirty_words = 0;
+}
+
+bool bloom_word_dirty(Bloom bloom, unsigned int word)
+{
+	return bloom->dirty != NULL && (bloom->dirty[word / 64] & ((uint64_t) 1 << (word % 64)));
+}
+
+unsigned int bloom_dirty_runs(Bloom bloom)
+{
+	if (bloom->dirty == NULL || bloom->dirty_words == 0)
+		return 0;
+
+	unsigned int runs = 0;
+	bool prev = false;		// whether the previous word was dirty
+	unsigned int words = bloom_num_words(bloom);
+	for (unsigned int i = 0; i < (words + 63) / 64; i++)
+	{
+		uint64_t bits = bloom->dirty[i];
+		if (bits == 0 && !prev)		// skip 64 clean words at once
+			continue;
+		// a run starts at every dirty word whose previous word is clean
+		uint64_t starts = bits & ~((bits << 1) | (prev ? 1 : 0));
+		runs += __builtin_popcountll(starts);
+		prev = (bits >> 63) & 1;
+	}
+	return runs;
+}
+
+void bloom_clear_dirty(Bloom bloom)
+{
+	if (bloom->dirty == NULL || bloom->dirty_words == 0)
+		return;
+	memset(bloom->dirty, 0, ((bloom_num_words(bloom) + 63) / 64) * sizeof(uint64_t));
+	bloom->dirty_words = 0;
+}
+
+void bloom_get_words(Bloom bloom, unsigned int first, unsigned int count, void * dest)
+{
+	size_t bytes = bloom->size / 8;
+	size_t start = (size_t) first * BLOOM_WORD_SIZE;
+	size_t n = (size_t) count * BLOOM_WORD_SIZE;
+	assert(start + n < bytes + BLOOM_WORD_SIZE);
+	if (start + n > bytes)		// the last word is partial
+	{
+		memset(dest + (bytes - start), 0, start + n - bytes);
+		n = bytes - start;
+	}
+	memcpy(dest, bloom->bit_array + start, n);
+}
+
+void bloom_set_words(Bloom bloom, unsigned int first, unsigned int count, const void * src)
+{
+	size_t bytes = bloom->size / 8;
+	size_t start = (size_t) first * BLOOM_WORD_SIZE;
+	size_t n = (size_t) count * BLOOM_WORD_SIZE;
+	assert(start + n < bytes + BLOOM_WORD_SIZE);
+	if (start + n > bytes)		// the last word is partial, its padding is ignored
+		n = bytes - start;
+	memcpy(bloom->bit_array + start, src, n);
+}
+
 void bloom_destroy(Bloom bloom)
 {
 	if (bloom == NULL)
 		fprintf(stderr, "Error : bloom_delete -> bloom is NULL\n");
 	assert(bloom != NULL);
 
-	free(bloom->bit_array);		// free bit array of bloom filter
+	if (bloom->shared)			// unmap the shared bit array of bloom filter
+	{
+		munmap(bloom->bit_array, (bloom->size / 8) * sizeof(uint8_t));
+		if (bloom->shm_fd >= 0)
+			close(bloom->shm_fd);
+	}
+	else
+		free(bloom->bit_array);		// free bit array of bloom filter
+	free(bloom->dirty);
+	free(bloom->counters);
 	free(bloom);		// free the pointer to the bloom filter structure itself
 
 }
\ No newline at end of file
@@ -3,31 +3,77 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#define K 16 // the number of hash functions the filter uses
+#define BLOOM_MAX_K 32			// the max number of hash functions (probes) a filter uses
+#define BLOOM_FP_RATE 0.001		// target false positive rate, used to choose the number of hash functions (see bloom_optimal_k)
+#define BLOOM_BLOCK_BITS 512	// size of a block of a blocked bloom filter, one cache line
+#define BLOOM_WORD_SIZE sizeof(uint64_t)	// the bit array is also seen as 64-bit words, the unit of the delta updates (the last word may be partial)
 
 // data struct for bloom filter
 struct bloom_filter {
 	uint8_t * bit_array;
 	unsigned int size;
+	unsigned int k;				// the number of hash functions (probes) the filter uses
+	bool blocked;				// if true, all the bits of an object are in a single block (cache line) of BLOOM_BLOCK_BITS bits
+	unsigned int blocks;		// number of blocks of a blocked bloom filter (the bytes of bit_array after the last block are not used)
+	int shm_fd;					// memfd of the shared memory segment where bit_array is mapped, -1 if bit_array is private memory
+	bool shared;				// true if bit_array is a mapping of a shared memory segment (created here or attached from another process)
+	unsigned int generation;	// number of inserts into the filter, so that its owner can tell if it changed since some point
+	uint64_t * dirty;			// bitmap with one bit per word of bit_array, set if the word changed since the last bloom_clear_dirty (NULL if not tracked)
+	unsigned int dirty_words;	// number of bits set in dirty
+	uint8_t * counters;			// one counter per bit, of the objects that set it, so that objects can be removed (NULL if not counting)
 };
 
 typedef struct bloom_filter* Bloom;
 
-/* first hash function : djb2*/
-unsigned long djb2(unsigned char *str);
-/* second hash function : sdbm*/
-unsigned long sdbm(unsigned char *str);
-/* Return the result of the Kth hash function. This function uses djb2 and sdbm. */
-unsigned long hash_i(unsigned char *str, unsigned int i);
-/* creates a bloom filter of given size, returns a pointer to the structure */
-Bloom bloom_create(unsigned int bloom_size);
+/* returns a 64-bit hash of given string, computed in a single pass, numeric strings (citizenIDs) are hashed by their value */
+/* the k probes of the filter are derived from this hash with double hashing */
+uint64_t bloom_hash(unsigned char * string);
+/* returns the number of hash functions for a bloom filter of given size (in bytes) that is expected to hold expected objects */
+/* it is the smallest one that reaches a false positive rate of fp_rate, or the one with the least false positive rate if none does */
+unsigned int bloom_optimal_k(unsigned int bloom_size, unsigned long expected, double fp_rate);
+/* creates a bloom filter of given size, that uses k hash functions, returns a pointer to the structure */
+/* if blocked, the bloom filter is blocked (one cache line per lookup), as long as it has room for at least one block */
+/* the rest of the constructors take the same k and blocked, both processes that see a bloom filter must agree on them */
+Bloom bloom_create(unsigned int bloom_size, unsigned int k, bool blocked);
+/* creates a bloom filter of given size, whose bit array is kept in a shared memory segment (memfd) that other processes can map */
+/* through /proc/<pid>/fd/<shm_fd>, returns NULL if the segment could not be created */
+Bloom bloom_create_shared(unsigned int bloom_size, unsigned int k, bool blocked);
+/* creates a bloom filter of given size, whose bit array is a read only mapping of the shared memory segment at given path */
+/* (the bit array of a bloom filter created with bloom_create_shared), returns NULL if the segment could not be mapped */
+Bloom bloom_attach(unsigned int bloom_size, unsigned int k, bool blocked, const char * path);
 /* creates and returns a bloom filter , which is an exact copy of the bloom info (bit_array) given*/
-Bloom bloom_copy_create(unsigned int bloom_size, void * bit_array);
+Bloom bloom_copy_create(unsigned int bloom_size, unsigned int k, bool blocked, void * bit_array);
 /* updates the bloom filters bit array with the one given */
 void bloom_bit_array_copy(Bloom bloom, void * bit_array);
 /* checks if a given object-string is in bloom filter */
 bool bloom_check(Bloom bloom, unsigned char * string);
 /* inserts given object-string into bloom filter */
 void bloom_insert(Bloom bloom, unsigned char * string);
+/* returns the number of 64-bit words of the bit array of bloom filter */
+unsigned int bloom_num_words(Bloom bloom);
+/* starts keeping track of the words of the bit array that change on inserts, until the next bloom_clear_dirty */
+void bloom_track_dirty(Bloom bloom);
+/* returns true if given word of the bit array changed since the last bloom_clear_dirty */
+bool bloom_word_dirty(Bloom bloom, unsigned int word);
+/* returns the number of runs (maximal sequences of consecutive words) of changed words since the last bloom_clear_dirty */
+unsigned int bloom_dirty_runs(Bloom bloom);
+/* marks all words of the bit array as unchanged */
+void bloom_clear_dirty(Bloom bloom);
+/* copies count words of the bit array starting from word first into dest (the last word of bit array is padded with zeros) */
+void bloom_get_words(Bloom bloom, unsigned int first, unsigned int count, void * dest);
+/* overwrites count words of the bit array starting from word first with the ones in src */
+void bloom_set_words(Bloom bloom, unsigned int first, unsigned int count, const void * src);
+/* adds the objects of bloom filter other (of the same size, k and layout, and not counting) to bloom, by or-ing its bit array into */
+/* the one of bloom (the words that change are marked, as on inserts) */
+void bloom_merge(Bloom bloom, Bloom other);
+/* makes the (empty) bloom filter a counting one, that keeps a counter per bit, so that objects can also be removed with bloom_remove */
+/* the bit array stays the same (a bit is set iff its counter is not zero), so a counting bloom filter is sent and checked as any other */
+void bloom_track_counts(Bloom bloom);
+/* removes given object-string, that was inserted before, from a counting bloom filter, returns false if it definitely was not in it */
+/* (a counter that reached its max value is never decremented, so that objects that share it are not lost) */
+bool bloom_remove(Bloom bloom, unsigned char * string);
+/* checks n object-strings at once, maybe[i] is set to what bloom_check would return for strings[i] */
+/* the probes of many strings are done in parallel (AVX2 gathers if the cpu supports them, otherwise prefetching) */
+void bloom_check_many(Bloom bloom, unsigned char ** strings, unsigned int n, bool * maybe);
 /* deletes bloom filter data structure */
 void bloom_destroy(Bloom bloom);
@@ -0,0 +1,256 @@
+/*file : bptree.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "bptree.h"
+#include <assert.h>
+
+typedef struct bptree_node * BPTreeNode;
+
+// data struct for node of B+tree
+// an inner node of count keys has count + 1 children, child i has the keys k with keys[i-1] <= k < keys[i]
+// a leaf of count keys has the value of each one
+struct bptree_node {
+	bool leaf;
+	int count;
+	uint64_t keys[BPTREE_ORDER];
+	union {
+		BPTreeNode child[BPTREE_ORDER + 1];
+		struct {
+			void * values[BPTREE_ORDER];
+			BPTreeNode next;		// next leaf, in key order
+		};
+	};
+};
+
+// data struct for B+tree
+struct bptree {
+	BPTreeNode root;
+	int size;				// number of entries
+	BPTreeNode * blocks;	// blocks of nodes, where the nodes are allocated from (see block_nodes)
+	int num_blocks;
+	int used;				// nodes of the last block already used
+};
+
+// number of nodes of the b-th block of the arena, the blocks double in size up to BPTREE_ARENA_NODES, so that a small tree stays small
+static inline int block_nodes(int b)
+{
+	return (b < 6 && (1 << b) < BPTREE_ARENA_NODES) ? (1 << b) : BPTREE_ARENA_NODES;
+}
+
+BPTree bptree_create(void)
+{
+	BPTree tree = malloc(sizeof(struct bptree));
+	if (tree == NULL)
+		fprintf(stderr, "Error : bptree_create -> malloc\n");
+	assert(tree != NULL);
+
+	tree->root = NULL;
+	tree->size = 0;
+	tree->blocks = NULL;
+	tree->num_blocks = 0;
+	tree->used = 0;
+	return tree;
+}
+
+// returns a new node from the arena of the tree
+static BPTreeNode node_alloc(BPTree tree, bool leaf)
+{
+	if (tree->num_blocks == 0 || tree->used == block_nodes(tree->num_blocks - 1))		// last block is full, allocate a new one
+	{
+		tree->blocks = realloc(tree->blocks, (tree->num_blocks + 1) * sizeof(BPTreeNode));
+		if (tree->blocks == NULL)
+			fprintf(stderr, "Error : node_alloc -> realloc\n");
+		assert(tree->blocks != NULL);
+		tree->blocks[tree->num_blocks] = malloc(block_nodes(tree->num_blocks) * sizeof(struct bptree_node));
+		if (tree->blocks[tree->num_blocks] == NULL)
+			fprintf(stderr, "Error : node_alloc -> malloc\n");
+		assert(tree->blocks[tree->num_blocks] != NULL);
+		tree->num_blocks++;
+		tree->used = 0;
+	}
+
+	BPTreeNode node = &tree->blocks[tree->num_blocks - 1][tree->used++];
+	node->leaf = leaf;
+	node->count = 0;
+	if (leaf)
+		node->next = NULL;
+	return node;
+}
+
+// returns the number of keys of node that are less than or equal to key, i.e. the child of an inner node to follow for key
+static inline int upper_bound(BPTreeNode node, uint64_t key)
+{
+	int low = 0, high = node->count;
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (node->keys[mid] <= key)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+// returns the number of keys of node that are less than key, i.e. the position of key in a leaf
+static inline int lower_bound(BPTreeNode node, uint64_t key)
+{
+	int low = 0, high = node->count;
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (node->keys[mid] < key)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+// returns the leaf where key is (or would be)
+static BPTreeNode find_leaf(BPTree tree, uint64_t key)
+{
+	BPTreeNode node = tree->root;
+	while (node != NULL && !node->leaf)
+		node = node->child[upper_bound(node, key)];
+	return node;
+}
+
+// inserts into the subtree of node, returns -1 if key already exists, 1 if node was split (the new right node and its first key
+// are returned in right and right_key), 0 otherwise
+static int node_insert(BPTree tree, BPTreeNode node, uint64_t key, void * value, BPTreeNode * right, uint64_t * right_key)
+{
+	int half = BPTREE_ORDER / 2;
+	if (node->leaf)
+	{
+		int i = lower_bound(node, key);
+		if (i < node->count && node->keys[i] == key)
+			return -1;
+
+		// make room for the new entry at i
+		memmove(&node->keys[i + 1], &node->keys[i], (node->count - i) * sizeof(uint64_t));
+		memmove(&node->values[i + 1], &node->values[i], (node->count - i) * sizeof(void *));
+		node->keys[i] = key;
+		node->values[i] = value;
+		node->count++;
+		if (node->count < BPTREE_ORDER)
+			return 0;
+
+		// leaf is full, its upper half moves to a new leaf, next to it
+		BPTreeNode new_leaf = node_alloc(tree, true);
+		new_leaf->count = node->count - half;
+		memcpy(new_leaf->keys, &node->keys[half], new_leaf->count * sizeof(uint64_t));
+		memcpy(new_leaf->values, &node->values[half], new_leaf->count * sizeof(void *));
+		node->count = half;
+		new_leaf->next = node->next;
+		node->next = new_leaf;
+		*right = new_leaf;
+		*right_key = new_leaf->keys[0];
+		return 1;
+	}
+
+	int i = upper_bound(node, key);
+	BPTreeNode child_right;
+	uint64_t child_key;
+	int result = node_insert(tree, node->child[i], key, value, &child_right, &child_key);
+	if (result <= 0)
+		return result;
+
+	// the child was split, its new right node goes right after it
+	memmove(&node->keys[i + 1], &node->keys[i], (node->count - i) * sizeof(uint64_t));
+	memmove(&node->child[i + 2], &node->child[i + 1], (node->count - i) * sizeof(BPTreeNode));
+	node->keys[i] = child_key;
+	node->child[i + 1] = child_right;
+	node->count++;
+	if (node->count < BPTREE_ORDER)
+		return 0;
+
+	// inner node is full, its middle key moves up and the keys after it (with their children) move to a new node
+	BPTreeNode new_node = node_alloc(tree, false);
+	new_node->count = node->count - half - 1;
+	memcpy(new_node->keys, &node->keys[half + 1], new_node->count * sizeof(uint64_t));
+	memcpy(new_node->child, &node->child[half + 1], (new_node->count + 1) * sizeof(BPTreeNode));
+	*right_key = node->keys[half];
+	node->count = half;
+	*right = new_node;
+	return 1;
+}
+
+bool bptree_insert(BPTree tree, uint64_t key, void * value)
+{
+	if (tree == NULL)
+		fprintf(stderr, "Error : bptree_insert -> tree is NULL\n");
+	assert(tree != NULL);
+
+	if (tree->root == NULL)
+		tree->root = node_alloc(tree, true);
+
+	BPTreeNode right;
+	uint64_t right_key;
+	int result = node_insert(tree, tree->root, key, value, &right, &right_key);
+	if (result < 0)
+		return false;
+	if (result > 0)		// root was split, a new root is added on top of the two halves
+	{
+		BPTreeNode root = node_alloc(tree, false);
+		root->count = 1;
+		root->keys[0] = right_key;
+		root->child[0] = tree->root;
+		root->child[1] = right;
+		tree->root = root;
+	}
+	tree->size++;
+	return true;
+}
+
+bool bptree_delete(BPTree tree, uint64_t key)
+{
+	if (tree == NULL)
+		fprintf(stderr, "Error : bptree_delete -> tree is NULL\n");
+	assert(tree != NULL);
+
+	BPTreeNode leaf = find_leaf(tree, key);
+	if (leaf == NULL)
+		return false;
+	int i = lower_bound(leaf, key);
+	if (i == leaf->count || leaf->keys[i] != key)
+		return false;
+
+	memmove(&leaf->keys[i], &leaf->keys[i + 1], (leaf->count - i - 1) * sizeof(uint64_t));
+	memmove(&leaf->values[i], &leaf->values[i + 1], (leaf->count - i - 1) * sizeof(void *));
+	leaf->count--;
+	tree->size--;
+	return true;
+}
+
+int bptree_size(BPTree tree)
+{
+	return tree->size;
+}
+
+void bptree_traverse(BPTree tree, void (*visit)(void * value, void * arg), void * arg)
+{
+	if (tree == NULL)
+		fprintf(stderr, "Error : bptree_traverse -> tree is NULL\n");
+	assert(tree != NULL);
+
+	BPTreeNode leaf = tree->root;
+	while (leaf != NULL && !leaf->leaf)		// the leftmost leaf, and then all the leaves through their links
+		leaf = leaf->child[0];
+	for (; leaf != NULL; leaf = leaf->next)
+		for (int i = 0; i < leaf->count; ++i)
+			visit(leaf->values[i], arg);
+}
+
+void bptree_destroy(BPTree tree)
+{
+	if (tree == NULL)
+		fprintf(stderr, "Error : bptree_destroy -> tree is NULL\n");
+	assert(tree != NULL);
+
+	for (int b = 0; b < tree->num_blocks; ++b)
+		free(tree->blocks[b]);
+	free(tree->blocks);
+	free(tree);
+}
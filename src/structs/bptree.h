@@ -0,0 +1,27 @@
+/*file : bptree.h*/
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/* B+tree : ordered index of values by integer key, all values are in the leaves, that are linked in key order */
+/* every node has up to BPTREE_ORDER keys in a contiguous array, so that a search is a few binary searches over cache lines, logarithmic */
+/* in the number of keys with a base of about BPTREE_ORDER / 2, and the nodes are allocated in blocks (arena), not one by one   */
+
+#define BPTREE_ORDER 32			// max keys per node
+#define BPTREE_ARENA_NODES 64	// max nodes allocated at once (the first blocks are smaller)
+
+typedef struct bptree * BPTree;
+
+/* creates an empty B+tree and returns a pointer to the structure */
+BPTree bptree_create(void);
+/* inserts given value under given key, returns false (and inserts nothing) if key already exists */
+bool bptree_insert(BPTree tree, uint64_t key, void * value);
+/* deletes the entry with given key, returns false if it does not exist */
+/* (nodes are not merged, a node that lost keys is filled again by the inserts that fall into it) */
+bool bptree_delete(BPTree tree, uint64_t key);
+/* returns the number of entries of the tree */
+int bptree_size(BPTree tree);
+/* calls visit for the value of each entry of the tree, in increasing order of key, with given arg */
+void bptree_traverse(BPTree tree, void (*visit)(void * value, void * arg), void * arg);
+/* deletes the tree structure (but not its values) */
+void bptree_destroy(BPTree tree);
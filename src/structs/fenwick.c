@@ -0,0 +1,108 @@
+/*file : fenwick.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include "fenwick.h"
+#include <assert.h>
+
+// data struct for Fenwick tree
+// the key base + i - 1 is at position i (1 <= i <= size), and sums[i] is the number of events at positions i - lowbit(i) + 1 up to i
+struct fenwick {
+	unsigned int base;		// first key covered
+	int size;				// number of keys covered (a power of 2)
+	int * sums;				// size + 1 partial sums (sums[0] is not used)
+};
+
+static inline int lowbit(int i)
+{
+	return i & -i;
+}
+
+Fenwick fenwick_create(void)
+{
+	Fenwick tree = malloc(sizeof(struct fenwick));
+	if (tree == NULL)
+		fprintf(stderr, "Error : fenwick_create -> malloc\n");
+	assert(tree != NULL);
+
+	tree->base = 0;
+	tree->size = 0;		// the window is placed around the first key added
+	tree->sums = NULL;
+	return tree;
+}
+
+// number of events at positions 1 up to i
+static int prefix(Fenwick tree, int i)
+{
+	int sum = 0;
+	for (; i > 0; i -= lowbit(i))
+		sum += tree->sums[i];
+	return sum;
+}
+
+// moves the window of tree to the keys base up to base + size - 1 (that cover all the keys of the old window)
+static void resize(Fenwick tree, unsigned int base, int size)
+{
+	int * sums = calloc(size + 1, sizeof(int));
+	if (sums == NULL)
+		fprintf(stderr, "Error : fenwick resize -> calloc\n");
+	assert(sums != NULL);
+
+	// the count of each old key goes to its new position, and then the partial sums are built in linear time
+	for (int i = 1; i <= tree->size; ++i)
+		sums[tree->base - base + i] = prefix(tree, i) - prefix(tree, i - 1);
+	for (int i = 1; i <= size; ++i)
+		if (i + lowbit(i) <= size)
+			sums[i + lowbit(i)] += sums[i];
+
+	free(tree->sums);
+	tree->sums = sums;
+	tree->base = base;
+	tree->size = size;
+}
+
+void fenwick_add(Fenwick tree, unsigned int key, int count)
+{
+	if (tree == NULL)
+		fprintf(stderr, "Error : fenwick_add -> tree is NULL\n");
+	assert(tree != NULL);
+
+	if (tree->size == 0)		// first key, the window is centered on it
+		resize(tree, (key >= FENWICK_MIN_SIZE / 2) ? key - FENWICK_MIN_SIZE / 2 : 0, FENWICK_MIN_SIZE);
+	while (key < tree->base || key - tree->base >= (unsigned int) tree->size)		// double the window towards key, until it covers it
+	{
+		if (key < tree->base)
+			resize(tree, (tree->base >= (unsigned int) tree->size) ? tree->base - tree->size : 0, 2 * tree->size);
+		else
+			resize(tree, tree->base, 2 * tree->size);
+	}
+
+	for (int i = key - tree->base + 1; i <= tree->size; i += lowbit(i))
+		tree->sums[i] += count;
+}
+
+int fenwick_range(Fenwick tree, unsigned int first, unsigned int last)
+{
+	if (tree == NULL)
+		fprintf(stderr, "Error : fenwick_range -> tree is NULL\n");
+	assert(tree != NULL);
+
+	if (tree->size == 0 || first > last)
+		return 0;
+	// only the part of the range inside the window has events
+	unsigned int end = tree->base + tree->size - 1;		// last key covered
+	if (last < tree->base || first > end)
+		return 0;
+	int from = (first > tree->base) ? first - tree->base + 1 : 1;
+	int to = (last < end) ? last - tree->base + 1 : tree->size;
+	return prefix(tree, to) - prefix(tree, from - 1);
+}
+
+void fenwick_destroy(Fenwick tree)
+{
+	if (tree == NULL)
+		fprintf(stderr, "Error : fenwick_destroy -> tree is NULL\n");
+	assert(tree != NULL);
+
+	free(tree->sums);
+	free(tree);
+}
@@ -0,0 +1,19 @@
+/*file : fenwick.h*/
+#pragma once
+
+/* Fenwick tree (binary indexed tree) : counts of events by an integer key (e.g. a day number, see date.h), where the number of */
+/* events with keys in a range is found in O(log n), and so is adding events, n being the width of the range of keys seen so far */
+/* the tree covers a window of keys around the ones added, that doubles (and the tree is rebuilt) whenever a key falls outside of it */
+
+#define FENWICK_MIN_SIZE 64		// keys covered by a new tree
+
+typedef struct fenwick * Fenwick;
+
+/* creates an empty tree */
+Fenwick fenwick_create(void);
+/* adds count events with given key */
+void fenwick_add(Fenwick tree, unsigned int key, int count);
+/* returns the number of events with keys from first up to last (inclusive) */
+int fenwick_range(Fenwick tree, unsigned int first, unsigned int last);
+/* deletes the tree */
+void fenwick_destroy(Fenwick tree);
@@ -1,32 +1,90 @@
 /*file : hash.c*/
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include "hash.h"
-#include "list.h"
-#include "m_items.h"
-#include "tm_items.h"
 #include <assert.h>
 
 #define MAX_LOAD_FACTOR 0.75
+#define MIN_CAPACITY 8
+#define MIGRATE_STEP 8		// slots of the previous table moved to the current one on each insert, while the table grows
 
 // data struct for hash table
+// a flat table with open addressing (linear probing) : each slot keeps a value, and a tag of the hash of its key, so that a search
+// only looks at the key of a value when the tags match, and the values are moved to a bigger table without hashing their keys again
+// when the table grows, the values of the previous table are moved to the new one a few slots per insert (incremental rehashing),
+// so that no single insert has to move all of them. The previous table is left as is until all of its slots are moved, so that its
+// probe sequences stay intact and the values not yet moved are still found there
 struct hash_table {
-	List *table;		// hash table implemented as an array of linked lists
+	uint32_t * tags;	// tag of each slot, 0 if the slot is empty
+	void ** values;		// value of each slot
 	int size;			// number of elements added
-	int capacity;		// number of buckets
-	int type;			// 0 : table of lists of citizens info nodes. 1: table of lists of virus info nodes(parent) 2 : table of lists of countries info nodes (parent) 4 : table of lists of virus info nodes (child) 5 : table of lists of country info nodes (child)
+	int capacity;		// number of slots, always a power of 2
+	int shift;			// 64 - log2(capacity), a slot is given by the top bits of the (mixed) tag
+	uint32_t * prev_tags;	// the previous table, while its values are being moved to the current one (NULL otherwise)
+	void ** prev_values;
+	int prev_capacity;
+	int prev_shift;
+	int migrated;		// slots of the previous table before this one have been moved to the current one
+	HashKey key;		// returns the key of a value
+	HashDestroy destroy;	// deletes a value (NULL if the values are not owned by the hash table)
 };
 
 unsigned long hash_function(unsigned char *str) {
 	unsigned long hash = 5381;
-	int c; 
+	int c;
 	while ((c = *str++)) {
 		hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
 	}
 	return hash;
 }
 
-HT hash_create(int capacity, int type)
+// the tag of a key, never 0 since that marks an empty slot
+static uint32_t tag_of(void * key)
+{
+	unsigned long hash = hash_function((unsigned char *) key);
+	uint32_t tag = (uint32_t) (hash ^ (hash >> 32));
+	return (tag != 0) ? tag : 1;
+}
+
+// the first slot to probe for a tag in a table of given shift (multiplicative hashing, so that the slot depends on all bits of the tag)
+static inline int slot_of(int shift, uint32_t tag)
+{
+	return (int) (((uint64_t) tag * 0x9e3779b97f4a7c15ULL) >> shift);
+}
+
+// searches the table of given slots for given key
+static void * table_search(uint32_t * tags, void ** values, int capacity, int shift, HashKey get_key, uint32_t tag, void * key)
+{
+	int mask = capacity - 1;
+	// probe until an empty slot, the key is in one of the slots before it, if it exists
+	for (int i = slot_of(shift, tag); tags[i] != 0; i = (i + 1) & mask)
+	{
+		if (tags[i] == tag && !strcmp(get_key(values[i]), (char *) key))
+			return values[i];
+	}
+	return NULL;
+}
+
+static void table_alloc(HT hash, int capacity)
+{
+	hash->capacity = MIN_CAPACITY;
+	hash->shift = 64 - 3;
+	while (hash->capacity < capacity)
+	{
+		hash->capacity *= 2;
+		hash->shift--;
+	}
+
+	hash->tags = calloc(hash->capacity, sizeof(uint32_t));		// all slots are empty
+	hash->values = malloc(hash->capacity * sizeof(void *));
+	if (hash->tags == NULL || hash->values == NULL)
+		fprintf(stderr, "Error : hash_create -> malloc\n");
+	assert(hash->tags != NULL && hash->values != NULL);
+}
+
+HT hash_create(int capacity, HashKey key, HashDestroy destroy)
 {
 	//malloc HT structure
 	HT hash = malloc(sizeof(struct hash_table));
@@ -34,19 +92,15 @@ HT hash_create(int capacity, int type)
 		fprintf(stderr, "Error : hash_create -> malloc\n");
 	assert(hash != NULL);
 
-	// malloc hash table of given size, of pointers to lists
-  	hash->table = malloc(capacity * sizeof(List));
-	if (hash->table == NULL)
-		fprintf(stderr, "Error : hash_create -> malloc\n");
-	assert(hash->table != NULL);
-
-	// initialize all list pointers of hashtable to NULL
-  	for (int i = 0; i < capacity; ++i)
-    	hash->table[i] = NULL;
-
-    hash->capacity = capacity;
+	table_alloc(hash, capacity);		// at least given capacity, rounded up to a power of 2
   	hash->size = 0;
-  	hash->type = type;
+	hash->prev_tags = NULL;
+	hash->prev_values = NULL;
+	hash->prev_capacity = 0;
+	hash->prev_shift = 0;
+	hash->migrated = 0;
+	hash->key = key;
+	hash->destroy = destroy;
 
 	return hash;
 }
@@ -75,14 +129,21 @@ void hash_destroy(HT hash)
 		fprintf(stderr, "Error : hash_destroy -> HT hash is NULL\n");
 	assert(hash != NULL);
 
-	for (int i = 0; i < hash->capacity; ++i)
+	if (hash->destroy != NULL)
 	{
-		if (hash->table[i] != NULL)
-			list_destroy(hash->table[i]);		//delete all linked lists of hash table
+		for (int i = 0; i < hash->capacity; ++i)
+			if (hash->tags[i] != 0)
+				hash->destroy(hash->values[i]);		//delete all values of hash table
+		for (int i = hash->migrated; i < hash->prev_capacity; ++i)		// and the ones not yet moved from the previous table
+			if (hash->prev_tags[i] != 0)
+				hash->destroy(hash->prev_values[i]);
 	}
 
 	// at last, delete the hash and hash_table data structure
-	free(hash->table);
+	free(hash->tags);
+	free(hash->values);
+	free(hash->prev_tags);
+	free(hash->prev_values);
 	free(hash);
 }
 
@@ -92,63 +153,58 @@ void * hash_search(HT hash, void * key)
 		fprintf(stderr, "Error : hash_search -> HT hash is NULL\n");
 	assert(hash != NULL);
 
-	int index = (int) (hash_function((unsigned char *) key) % hash->capacity);
-
-	if (hash->table[index] == NULL) 		// if no previous entry has hashed into that bucket
-		return NULL;  						// then obviously given key does not exist into the hash-table
-	else
-		return list_search(hash->table[index], key);
+	uint32_t tag = tag_of(key);
+	void * value = table_search(hash->tags, hash->values, hash->capacity, hash->shift, hash->key, tag, key);
+	if (value == NULL && hash->prev_tags != NULL)		// it may not have been moved from the previous table yet
+		value = table_search(hash->prev_tags, hash->prev_values, hash->prev_capacity, hash->prev_shift, hash->key, tag, key);
+	return value;
 }
 
-// if load factor becomes too large, rehash the hash table by doubling its capacity
-static void rehash(HT hash)
+// places value with given tag into the first empty slot of its probe sequence
+static void place(HT hash, uint32_t tag, void * value)
 {
-	// keep previous capacity, array of lists
-	int prev_capacity = hash->capacity;
-	List * prev_table = hash->table;
-
-	hash->capacity = hash->capacity*2; 		// double hash table's capacity
-
-	hash->table = malloc(hash->capacity * sizeof(List));  // malloc new hash table with double capacity
-	if (hash->table == NULL)
-		fprintf(stderr, "Error : rehash -> malloc\n");
-	assert(hash->table != NULL);
-
-	// re-initialize all list pointers of hashtable to NULL
-  	for (int i = 0; i < hash->capacity; ++i)
-    	hash->table[i] = NULL;
+	int mask = hash->capacity - 1;
+	int i = slot_of(hash->shift, tag);
+	while (hash->tags[i] != 0)
+		i = (i + 1) & mask;
+	hash->tags[i] = tag;
+	hash->values[i] = value;
+}
 
-    hash->size = 0;
+// moves up to count slots of the previous table to the current one, their tags give their new slots
+static void migrate(HT hash, int count)
+{
+	if (hash->prev_tags == NULL)
+		return;
 
-    // now re-insert all previous elements of the hash table to the bigger hash-table
-    for (int i = 0; i < prev_capacity; i++)
-    {
-    	if (prev_table[i] != NULL)
-    	{
-    		for (ListNode node = list_first(prev_table[i]); node != NULL; node = list_next(prev_table[i], node))
-    			hash_insert(hash, list_value(prev_table[i], node));
-    	}
-    }
+	for (; count > 0 && hash->migrated < hash->prev_capacity; count--, hash->migrated++)
+	{
+		if (hash->prev_tags[hash->migrated] != 0)
+			place(hash, hash->prev_tags[hash->migrated], hash->prev_values[hash->migrated]);
+	}
 
-    // finally, delete the previous hash-table
-    // Also delete the list nodes of previous hash-tables, but not their data, since the list nodes of new hash table point to that data
-    for (int i = 0; i < prev_capacity; ++i)
+	if (hash->migrated == hash->prev_capacity)		// all moved, delete the previous hash-table (but not the values, that are now in the current one)
 	{
-		if (prev_table[i] != NULL)		// for each not null list of previous hash-table
-		{
-			ListNode node = list_dummy(prev_table[i]); 		// starting from fake-dummy node
-			
-			while (node != NULL) 	// for every node of list
-			{				
-				ListNode next = list_next(prev_table[i], node);		// save next node
-				free(node);   // free node of list
-				node = next;  // continue iteration of list
-			}
-			// at last free the struct of list
-			free(prev_table[i]);
-		}
+		free(hash->prev_tags);
+		free(hash->prev_values);
+		hash->prev_tags = NULL;
+		hash->prev_values = NULL;
+		hash->prev_capacity = 0;
+		hash->migrated = 0;
 	}
-	free(prev_table);		// delete the hash_table itself
+}
+
+// makes a new table of at least given capacity the current one, the values of the current one are moved to it incrementally
+static void rehash(HT hash, int capacity)
+{
+	migrate(hash, hash->prev_capacity);		// a previous table that is still being moved is finished first
+
+	hash->prev_tags = hash->tags;
+	hash->prev_values = hash->values;
+	hash->prev_capacity = hash->capacity;
+	hash->prev_shift = hash->shift;
+	hash->migrated = 0;
+	table_alloc(hash, capacity);
 }
 
 void hash_insert(HT hash, void * value)
@@ -156,29 +212,27 @@ void hash_insert(HT hash, void * value)
 	if (hash == NULL)
 		fprintf(stderr, "Error : hash_search -> HT hash is NULL\n");
 	assert(hash != NULL);
-	void * key;
-	
-	switch (hash->type)
-	{
-		case 0 : key = m_get_citizen_id((M_CitizenInfo) value); break;
-		case 1 : key = m_get_virus_name((M_VirusInfo) value); break;
-		case 2 : key = m_get_country_name((M_CountryInfo) value); break;
-		case 4 : key = tm_get_virus_name((TM_VirusInfo) value); break;
-		case 5 : key = tm_get_country_name((TM_CountryInfo) value); break;
-	}
 
-	int index = (int) (hash_function((unsigned char *) key) % hash->capacity);
-
-	if (hash->table[index] == NULL) 		// if no previous entry has hashed into that bucket
-		hash->table[index] = list_create(hash->type);		// create new bucket-list at index
-	
-	list_insert_end(hash->table[index], value);			// insert value at end of list
+	place(hash, tag_of(hash->key(value)), value);
 	hash->size++;
+	migrate(hash, MIGRATE_STEP);
 
-	// If after insertion, load factor becomes too large, rehash the hash table
+	// If after insertion, load factor becomes too large, rehash the hash table by doubling its capacity
 	float load_factor = (float) hash->size / hash->capacity;
 	if (load_factor > MAX_LOAD_FACTOR)
-		rehash(hash);
+		rehash(hash, hash->capacity * 2);
+}
+
+void hash_reserve(HT hash, int count)
+{
+	if (hash == NULL)
+		fprintf(stderr, "Error : hash_reserve -> HT hash is NULL\n");
+	assert(hash != NULL);
+
+	if (count <= hash->capacity * MAX_LOAD_FACTOR)		// already has room
+		return;
+	rehash(hash, (int) (count / MAX_LOAD_FACTOR) + 1);
+	migrate(hash, hash->prev_capacity);		// done before the inserts, so the elements already in are moved at once
 }
 
 void hash_print(HT hash)
@@ -189,64 +243,43 @@ void hash_print(HT hash)
 
 	for (int i = 0; i < hash->capacity; ++i)
 	{
-		if (hash->table[i] != NULL)
-		{
-			printf("%d:chain \n\n", i);
-			list_print(hash->table[i]);
-		}
+		if (hash->tags[i] != 0)
+			printf("%d: %s\n", i, hash->key(hash->values[i]));
+	}
+	for (int i = hash->migrated; i < hash->prev_capacity; ++i)
+	{
+		if (hash->prev_tags[i] != 0)
+			printf("(previous) %d: %s\n", i, hash->key(hash->prev_values[i]));
 	}
 
 }
 
-void * hash_iterate_next(HT hash)
+// the slots of the current table are followed by the slots of the previous one (only the ones not yet moved hold elements)
+void hash_cursor_init(HT hash, struct hash_cursor * cursor)
 {
-	if (hash == NULL)
-		fprintf(stderr, "Error : hash_iterate_next -> HT hash is NULL\n");
-	assert(hash != NULL);
+	if (hash == NULL || cursor == NULL)
+		fprintf(stderr, "Error : hash_cursor_init -> invalid arguments\n");
+	assert(hash != NULL && cursor != NULL);
 
-	static ListNode cur_node = NULL;
-	static int index = 0;
+	cursor->hash = hash;
+	cursor->index = 0;
+}
 
-	if (cur_node == NULL)				// if the iteration of hash-table begins now
+void * hash_cursor_next(struct hash_cursor * cursor)
+{
+	HT hash = cursor->hash;
+	int end = hash->capacity + hash->prev_capacity;
+	for (; cursor->index < hash->capacity; ++cursor->index)		// search for next non-empty slot of hash-table
 	{
-		for (int i = 0; i < hash->capacity; ++i)
-		{
-			if (hash->table[i] != NULL)
-			{
-				cur_node = list_first(hash->table[i]);
-				index = i;
-				return (list_value(hash->table[i], cur_node));
-			}
-		}
-
-		return NULL;		// no elements found
+		if (hash->tags[cursor->index] != 0)
+			return hash->values[cursor->index++];		// return the element, the iteration goes on from the next slot
 	}
-	else
-	{	// iteration has already begun
-		if (list_next(hash->table[index], cur_node) != NULL)	// if current list's next element is not NULL
-		{
-			cur_node = list_next(hash->table[index], cur_node);		// save next node
-			return (list_value(hash->table[index], cur_node));		// return next element
-		}
-		else
-		{	// we have reached end of current list
-			for (int i = index+1; i < hash->capacity; ++i)  // search for next non-empty list of hash-table
-			{
-				if (hash->table[i] != NULL)					// if you find such a list
-				{
-					cur_node = list_first(hash->table[i]);	// save first node , to start traversing the list
-					index = i;
-					return (list_value(hash->table[i], cur_node));	// and obviously return the element
-				}
-			}
-
-			// reached end of iteration over all entries of hash table
-			cur_node = NULL;		// re-initialize cur_node, index to NULL, 0 for any iteration that may follow
-			index = 0;	
-			return NULL;			// no remaining elements found
-		}
+	if (cursor->index - hash->capacity < hash->migrated)		// the slots already moved from the previous table are skipped
+		cursor->index = hash->capacity + hash->migrated;
+	for (; cursor->index < end; ++cursor->index)
+	{
+		if (hash->prev_tags[cursor->index - hash->capacity] != 0)
+			return hash->prev_values[cursor->index++ - hash->capacity];
 	}
-
-	return NULL;
-
+	return NULL;	// no remaining elements found
 }
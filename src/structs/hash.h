@@ -1,24 +1,40 @@
 /*file : hash.h */
 #pragma once
-#include "list.h"
 
 typedef struct hash_table * HT;
 
+// returns the key (a string) of given value of a hash table
+typedef char * (*HashKey)(void * value);
+// deletes given value of a hash table, when the hash table is deleted
+typedef void (*HashDestroy)(void * value);
+
 // a simple hash function for strings
 unsigned long hash_function(unsigned char *str);
-// creates hash table structure of given capacity
-HT hash_create(int capacity, int type);
+// creates hash table structure of given capacity, whose values have keys given by key, and are deleted with destroy (NULL if they are not)
+HT hash_create(int capacity, HashKey key, HashDestroy destroy);
 // returns number of elements currently in hash table
 int hash_size(HT hash);
-// returns number of buckets currently in hash table
+// returns number of slots currently in hash table
 int hash_capacity(HT hash);
 // deletes the hash table structure
 void hash_destroy(HT hash);
 // inserts entry with given value
 void hash_insert(HT hash, void * value);
+// makes room for count elements in total, so that no rehashing is needed until then (a sizing hint, best given before the inserts)
+void hash_reserve(HT hash, int count);
 // searches for entry with given key
 void * hash_search(HT hash, void * key);
 //print hash table (debugging)
 void hash_print(HT hash);
-// function that is used to iterate through hash table
-void * hash_iterate_next(HT hash);
\ No newline at end of file
+
+// a cursor over the elements of a hash table, any number of cursors can be used at the same time (e.g. nested iterations),
+// as long as the hash table does not change while they are used
+struct hash_cursor {
+	HT hash;
+	int index;		// next slot to look at
+};
+
+// sets cursor at the first element of hash table
+void hash_cursor_init(HT hash, struct hash_cursor * cursor);
+// returns the element at cursor and moves cursor to the next one, returns NULL if there are no more elements
+void * hash_cursor_next(struct hash_cursor * cursor);
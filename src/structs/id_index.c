@@ -0,0 +1,270 @@
+/*file : id_index.c */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "id_index.h"
+#include "hash.h"
+#include <assert.h>
+
+#define MAX_DIGITS 18		// the code of a numeric id of up to 18 digits is less than ID_INDEX_OTHER_KEYS (2^63), of 19 digits it may not be
+#define MAX_DIGITS_POWER 1000000000000000000ULL		// 10^MAX_DIGITS
+// the largest code is the one of MAX_DIGITS nines, 10^MAX_DIGITS - 1 plus the (10^MAX_DIGITS - 1) / 9 codes of the shorter ids
+_Static_assert(MAX_DIGITS_POWER - 1 + (MAX_DIGITS_POWER - 1) / 9 < ID_INDEX_OTHER_KEYS, "the codes of numeric ids must be less than ID_INDEX_OTHER_KEYS");
+#define RADIX_BITS 8		// bits of the code per level of the radix tree
+#define RADIX_FANOUT (1 << RADIX_BITS)
+#define RADIX_MAX_HEIGHT (64 / RADIX_BITS)
+
+// node of the radix tree, the children of the nodes of the last level are the values
+struct radix_node {
+	void * child[RADIX_FANOUT];
+};
+
+// data struct for id index
+struct id_index {
+	void ** dense;				// direct-address array of the ids of up to ID_INDEX_DENSE_DIGITS digits, by code (allocated on first use)
+	uint64_t dense_slots;		// number of slots of dense, the codes of these ids are less than it
+	struct radix_node * root;	// radix tree of the wider numeric ids, by code
+	int height;					// levels of the radix tree, its codes are less than 2^(RADIX_BITS * height) (0 if the tree is empty)
+	HT others;					// ids that are not numeric, or too wide
+	uint64_t other_keys;		// keys given to such ids so far (see id_index_key)
+	int size;					// number of values in index
+	HashKey key;				// returns the id of a value
+	HashDestroy destroy;		// deletes a value (NULL if the values are not owned by the index)
+};
+
+// the code of a numeric id of d digits is its value plus the number of codes of all the ids of less than d digits (1 + 10 + ... + 10^(d-1))
+// so that ids of the same value but different number of digits ("007", "7") have different codes, and that the codes are dense
+// returns false if id is not numeric, or wider than MAX_DIGITS digits
+bool id_index_code(char * id, uint64_t * code)
+{
+	uint64_t value = 0, base = 0;
+	int digits = 0;
+	for (; *id >= '0' && *id <= '9'; id++)
+	{
+		if (++digits > MAX_DIGITS)
+			return false;
+		value = value * 10 + (*id - '0');
+		base = base * 10 + 1;
+	}
+	if (*id != '\0' || digits == 0)
+		return false;
+	*code = base + value;
+	return true;
+}
+
+IdIndex id_index_create(HashKey key, HashDestroy destroy)
+{
+	IdIndex index = malloc(sizeof(struct id_index));
+	if (index == NULL)
+		fprintf(stderr, "Error : id_index_create -> malloc\n");
+	assert(index != NULL);
+
+	index->dense = NULL;
+	index->dense_slots = 1;
+	for (int i = 0; i < ID_INDEX_DENSE_DIGITS; ++i)		// codes of up to ID_INDEX_DENSE_DIGITS digits are less than 11...1 (one more 1)
+		index->dense_slots = index->dense_slots * 10 + 1;
+	index->root = NULL;
+	index->height = 0;
+	index->others = hash_create(8, key, NULL);		// its values are deleted along with the rest
+	index->other_keys = 0;
+	index->size = 0;
+	index->key = key;
+	index->destroy = destroy;
+
+	return index;
+}
+
+int id_index_size(IdIndex index)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : id_index_size -> index is NULL\n");
+	assert(index != NULL);
+
+	return index->size;
+}
+
+uint64_t id_index_key(IdIndex index, char * id)
+{
+	uint64_t code;
+	if (id_index_code(id, &code))
+		return code;
+	return ID_INDEX_OTHER_KEYS + index->other_keys++;
+}
+
+void id_index_claim_key(IdIndex index, uint64_t key)
+{
+	if (key >= ID_INDEX_OTHER_KEYS && key - ID_INDEX_OTHER_KEYS >= index->other_keys)
+		index->other_keys = key - ID_INDEX_OTHER_KEYS + 1;
+}
+
+static struct radix_node * radix_node_create(void)
+{
+	struct radix_node * node = calloc(1, sizeof(struct radix_node));
+	if (node == NULL)
+		fprintf(stderr, "Error : radix_node_create -> calloc\n");
+	assert(node != NULL);
+	return node;
+}
+
+// true if code is beyond the codes of a radix tree of given height
+static inline bool radix_beyond(uint64_t code, int height)
+{
+	return height < RADIX_MAX_HEIGHT && (code >> (RADIX_BITS * height)) != 0;
+}
+
+static void radix_insert(IdIndex index, uint64_t code, void * value)
+{
+	while (index->height == 0 || radix_beyond(code, index->height))		// add levels on top until the tree covers code
+	{
+		struct radix_node * root = radix_node_create();
+		root->child[0] = index->root;		// the old tree is the subtree of the smallest codes
+		index->root = root;
+		index->height++;
+	}
+
+	struct radix_node * node = index->root;
+	for (int level = index->height - 1; level > 0; --level)
+	{
+		int i = (code >> (RADIX_BITS * level)) & (RADIX_FANOUT - 1);
+		if (node->child[i] == NULL)
+			node->child[i] = radix_node_create();
+		node = node->child[i];
+	}
+	node->child[code & (RADIX_FANOUT - 1)] = value;
+}
+
+static void * radix_search(IdIndex index, uint64_t code)
+{
+	if (index->height == 0 || radix_beyond(code, index->height))
+		return NULL;
+
+	struct radix_node * node = index->root;
+	for (int level = index->height - 1; level > 0 && node != NULL; --level)
+		node = node->child[(code >> (RADIX_BITS * level)) & (RADIX_FANOUT - 1)];
+	return (node != NULL) ? node->child[code & (RADIX_FANOUT - 1)] : NULL;
+}
+
+static void radix_destroy(struct radix_node * node, int level, HashDestroy destroy)
+{
+	for (int i = 0; i < RADIX_FANOUT; ++i)
+	{
+		if (node->child[i] == NULL)
+			continue;
+		if (level > 0)
+			radix_destroy(node->child[i], level - 1, destroy);
+		else if (destroy != NULL)
+			destroy(node->child[i]);
+	}
+	free(node);
+}
+
+void id_index_insert(IdIndex index, void * value)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : id_index_insert -> index is NULL\n");
+	assert(index != NULL);
+
+	uint64_t code;
+	if (!id_index_code(index->key(value), &code))
+		hash_insert(index->others, value);
+	else if (code < index->dense_slots)
+	{
+		if (index->dense == NULL)
+			index->dense = calloc(index->dense_slots, sizeof(void *));
+		if (index->dense == NULL)
+			fprintf(stderr, "Error : id_index_insert -> calloc\n");
+		assert(index->dense != NULL);
+		index->dense[code] = value;
+	}
+	else
+		radix_insert(index, code, value);
+	index->size++;
+}
+
+void id_index_reserve(IdIndex index, int count)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : id_index_reserve -> index is NULL\n");
+	assert(index != NULL);
+
+	int others = hash_size(index->others);
+	if (count <= 0 || others == 0)		// no share of such ids is known yet
+		return;
+	hash_reserve(index->others, others + (int) ((double) count * others / index->size) + 1);
+}
+
+void * id_index_search(IdIndex index, char * id)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : id_index_search -> index is NULL\n");
+	assert(index != NULL);
+
+	uint64_t code;
+	if (!id_index_code(id, &code))
+		return hash_search(index->others, id);
+	if (code < index->dense_slots)
+		return (index->dense != NULL) ? index->dense[code] : NULL;
+	return radix_search(index, code);
+}
+
+static void radix_traverse(struct radix_node * node, int level, void (*visit)(void * value, void * arg), void * arg)
+{
+	for (int i = 0; i < RADIX_FANOUT; ++i)
+	{
+		if (node->child[i] == NULL)
+			continue;
+		if (level > 0)
+			radix_traverse(node->child[i], level - 1, visit, arg);
+		else
+			visit(node->child[i], arg);
+	}
+}
+
+void id_index_traverse(IdIndex index, void (*visit)(void * value, void * arg), void * arg)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : id_index_traverse -> index is NULL\n");
+	assert(index != NULL);
+
+	if (index->dense != NULL)
+		for (uint64_t i = 0; i < index->dense_slots; ++i)
+			if (index->dense[i] != NULL)
+				visit(index->dense[i], arg);
+	if (index->root != NULL)
+		radix_traverse(index->root, index->height - 1, visit, arg);
+
+	struct hash_cursor cursor;
+	void * value;
+	hash_cursor_init(index->others, &cursor);
+	while ((value = hash_cursor_next(&cursor)) != NULL)
+		visit(value, arg);
+}
+
+void id_index_destroy(IdIndex index)
+{
+	if (index == NULL)
+		fprintf(stderr, "Error : id_index_destroy -> index is NULL\n");
+	assert(index != NULL);
+
+	if (index->dense != NULL)
+	{
+		if (index->destroy != NULL)
+			for (uint64_t i = 0; i < index->dense_slots; ++i)
+				if (index->dense[i] != NULL)
+					index->destroy(index->dense[i]);
+		free(index->dense);
+	}
+	if (index->root != NULL)
+		radix_destroy(index->root, index->height - 1, index->destroy);
+	if (index->destroy != NULL)
+	{
+		struct hash_cursor cursor;
+		void * value;
+		hash_cursor_init(index->others, &cursor);
+		while ((value = hash_cursor_next(&cursor)) != NULL)
+			index->destroy(value);
+	}
+	hash_destroy(index->others);
+	free(index);
+}
@@ -0,0 +1,38 @@
+/*file : id_index.h */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "hash.h"
+
+/* index of values by an id (a string), for ids that are mostly numeric, like citizenIDs */
+/* a numeric id is looked up by its value (and number of digits, so that "007" and "7" differ), its code, without hashing or comparing strings : */
+/* ids of up to ID_INDEX_DENSE_DIGITS digits are slots of a direct-address array, wider ones (up to 18 digits) are keys of a radix tree */
+/* (8 bits per level, as many levels as the widest id needs), and the rest of the ids are kept in a hash table */
+
+#define ID_INDEX_DENSE_DIGITS 5
+#define ID_INDEX_OTHER_KEYS (1ULL << 63)	// keys of the ids that have no code (see id_index_key), all the codes are less than it
+
+typedef struct id_index * IdIndex;
+
+// creates an empty index, whose values have ids given by key, and are deleted with destroy (NULL if they are not)
+IdIndex id_index_create(HashKey key, HashDestroy destroy);
+// returns number of values currently in index
+int id_index_size(IdIndex index);
+// inserts given value, under its id
+void id_index_insert(IdIndex index, void * value);
+// makes room for count more values (a sizing hint, best given before the inserts) : the ids without a code are expected to be as many of
+// them as they are of the values already in index, and their hash table is sized for them (the arrays of the numeric ids never rehash)
+void id_index_reserve(IdIndex index, int count);
+// searches for the value with given id, returns NULL if there is none
+void * id_index_search(IdIndex index, char * id);
+// returns the code of given id in code, returns false if id is not numeric (or too wide) and has no code
+bool id_index_code(char * id, uint64_t * code);
+// returns an integer key for a new id, that is unique among the ids of the index and orders the numeric ids as numbers (by their code)
+// it is the code of the id if it has one, otherwise the next one of the keys from ID_INDEX_OTHER_KEYS on
+uint64_t id_index_key(IdIndex index, char * id);
+// marks given key (returned by id_index_key before, e.g. by another process) as taken, so that id_index_key does not return it again
+void id_index_claim_key(IdIndex index, uint64_t key);
+// calls visit for each value of the index, with given arg (numeric ids first, in order of their codes)
+void id_index_traverse(IdIndex index, void (*visit)(void * value, void * arg), void * arg);
+// deletes the index structure (and its values, if it was given a destroy function)
+void id_index_destroy(IdIndex index);
@@ -0,0 +1,59 @@
+/*file : intern.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include "intern.h"
+#include "hash.h"
+#include <assert.h>
+
+// data struct for intern table
+struct intern {
+	HT strings;			// the strings, each one is its own key
+	Arena arena;		// where the strings are kept
+};
+
+static char * string_key(void * value)
+{
+	return (char *) value;
+}
+
+Intern intern_create(Arena arena)
+{
+	Intern table = malloc(sizeof(struct intern));
+	if (table == NULL)
+		fprintf(stderr, "Error : intern_create -> malloc\n");
+	assert(table != NULL);
+
+	table->strings = hash_create(64, string_key, NULL);
+	table->arena = arena;
+	return table;
+}
+
+char * intern_string(Intern table, char * str)
+{
+	if (table == NULL)
+		fprintf(stderr, "Error : intern_string -> table is NULL\n");
+	assert(table != NULL);
+
+	char * copy = hash_search(table->strings, str);
+	if (copy == NULL)
+	{
+		copy = arena_strdup(table->arena, str);
+		hash_insert(table->strings, copy);
+	}
+	return copy;
+}
+
+int intern_size(Intern table)
+{
+	return hash_size(table->strings);
+}
+
+void intern_destroy(Intern table)
+{
+	if (table == NULL)
+		fprintf(stderr, "Error : intern_destroy -> table is NULL\n");
+	assert(table != NULL);
+
+	hash_destroy(table->strings);
+	free(table);
+}
@@ -0,0 +1,17 @@
+/*file : intern.h*/
+#pragma once
+#include "arena.h"
+
+/* intern table : keeps one copy of each distinct string (e.g. the first names and surnames of the citizens, that repeat a lot), */
+/* in an arena, so that equal strings share their memory, and are allocated once */
+
+typedef struct intern * Intern;
+
+/* creates an empty intern table, whose strings are kept in given arena (they are deleted with it) */
+Intern intern_create(Arena arena);
+/* returns the copy of given string kept by the table, it is added if there is none yet */
+char * intern_string(Intern table, char * str);
+/* returns the number of distinct strings of the table */
+int intern_size(Intern table);
+/* deletes the intern table (but not its strings, they belong to the arena) */
+void intern_destroy(Intern table);
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "list.h"
+#include "pool.h"
 #include <string.h>
 #include "m_items.h"
 #include "tm_items.h"
@@ -12,7 +13,7 @@ struct list {
 	int type;
 	// values for type :
 	// 0 : list of citizens info nodes (monitor). 1: list of virus info nodes (monitor) 2 : list of countries info nodes (monitor) 3 : list of txt filenames (monitor)
-	// 4 : list of virus info nodes (travel monitor) 5 : list of country info nodes (travel monitor) 6 : list of travel request nodes
+	// 4 : list of virus info nodes (travel monitor) 5 : list of country info nodes (travel monitor)
 	ListNode dummy;  // fake first node, not really used, just a trick that makes insertion function simpler
 	ListNode last;   // pointer to last node.  Makes insertion at end O(1)
 	int size;
@@ -34,11 +35,8 @@ List list_create(int type)
 	assert(list != NULL);
 
 	list->size = 0;
-  	// malloc first-fake node
-	list->dummy = malloc(sizeof(*list->dummy));
-	if (list->dummy == NULL)
-		fprintf(stderr, "Error : list_create-> malloc\n");
-	assert(list->dummy != NULL);
+  	// first-fake node, from the pool of list nodes
+	list->dummy = pool_alloc(sizeof(*list->dummy));
 
 	list->dummy->next = NULL;
 	list->dummy->value = NULL;
@@ -65,14 +63,13 @@ void list_destroy(List list)
 				case 0 : m_citizen_info_destroy((M_CitizenInfo) node->value); break;
 				case 1 : m_virus_info_destroy((M_VirusInfo) node->value); break;
 				case 2 : m_country_info_destroy((M_CountryInfo) node->value); break;
-				case 3 : free(node->value); break;
+				case 3 : pool_free(node->value); break;
 				case 4 : tm_virus_info_destroy((TM_VirusInfo) node->value); break;
 				case 5 : tm_country_info_destroy((TM_CountryInfo) node->value); break;
-				case 6 : tm_travelRequest_destroy((TM_TravelRequest) node->value); break;
 			}
 		}
 		
-		free(node);   // free node of list
+		pool_free(node);   // free node of list
 		node = next;  // continue iteration of list
 	}
   	// at last free the struct of list
@@ -95,11 +92,8 @@ void list_insert_next(List list, ListNode node, void * value)
   	// if previous node is NULL, insertion at start is done
 	if (node == NULL)
 		node = list->dummy;
-  	// malloc new node
-	ListNode new_node = malloc(sizeof(*new_node));
-	if (new_node == NULL)
-		fprintf(stderr, "Error : list_insert_next -> malloc\n");
-	assert(new_node != NULL);
+  	// new node, from the pool of list nodes
+	ListNode new_node = pool_alloc(sizeof(*new_node));
 
   	// initialize new node's components
 	switch (list->type)
@@ -107,10 +101,9 @@ void list_insert_next(List list, ListNode node, void * value)
 		case 0 : new_node->value = (M_CitizenInfo) value; break;
 		case 1 : new_node->value = (M_VirusInfo) value; break;
 		case 2 : new_node->value = (M_CountryInfo) value; break;
-		case 3 : new_node->value = malloc(strlen((char *) value) + 1); strcpy((char *) new_node->value, (char *) value); break;
+		case 3 : new_node->value = pool_alloc(strlen((char *) value) + 1); strcpy((char *) new_node->value, (char *) value); break;
 		case 4 : new_node->value = (TM_VirusInfo) value; break;
 		case 5 : new_node->value = (TM_CountryInfo) value; break;
-		case 6 : new_node->value = (TM_TravelRequest) value; break;
 	}
 
 	// update pointers
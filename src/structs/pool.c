@@ -0,0 +1,154 @@
+/*file : pool.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "pool.h"
+#include <assert.h>
+
+// every object is preceded by a header with its size class (POOL_CLASSES for a large object), so that pool_free needs no size
+// the header keeps the objects aligned as malloc does
+union pool_header {
+	int size_class;
+	union pool_header * next;		// next free object of the same class, while the object is free
+	max_align_t align;
+};
+
+// pools of the calling thread
+struct pool_cache {
+	union pool_header * free[POOL_CLASSES];		// free objects of each class
+	int registered;								// whether free is handed to orphans when the thread exits
+};
+
+static __thread struct pool_cache cache;
+
+// an object may be freed by another thread than the one that allocated it, so the stats are kept for the whole process (atomically)
+static long live[POOL_CLASSES + 1];
+static long slabs;
+
+// free objects of the threads that have exited, taken by the next refill of their class instead of a new slab
+static union pool_header * orphans[POOL_CLASSES];
+static pthread_mutex_t orphans_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t exit_key;
+static pthread_once_t exit_once = PTHREAD_ONCE_INIT;
+
+// called when a thread that used the pools exits : hands its free objects to orphans
+static void cache_exit(void * value)
+{
+	struct pool_cache * exiting = value;
+	pthread_mutex_lock(&orphans_lock);
+	for (int c = 0; c < POOL_CLASSES; ++c)
+	{
+		union pool_header * header = exiting->free[c];
+		if (header == NULL)
+			continue;
+		while (header->next != NULL)
+			header = header->next;
+		header->next = orphans[c];
+		orphans[c] = exiting->free[c];
+		exiting->free[c] = NULL;
+	}
+	pthread_mutex_unlock(&orphans_lock);
+}
+
+static void exit_key_create(void)
+{
+	int error = pthread_key_create(&exit_key, cache_exit);
+	if (error)
+		fprintf(stderr, "Error : exit_key_create -> pthread_key_create\n");
+	assert(!error);
+}
+
+// returns the smallest size class whose objects fit size bytes, POOL_CLASSES if there is none
+static inline int size_class(size_t size)
+{
+	int c = 0;
+	while (c < POOL_CLASSES && ((size_t) POOL_MIN_SIZE << c) < size)
+		c++;
+	return c;
+}
+
+// refills the free list of given class, from orphans if there are any, else by cutting a new slab
+static void refill(int c)
+{
+	if (!cache.registered)
+	{
+		pthread_once(&exit_once, exit_key_create);
+		pthread_setspecific(exit_key, &cache);
+		cache.registered = 1;
+	}
+	pthread_mutex_lock(&orphans_lock);
+	cache.free[c] = orphans[c];
+	orphans[c] = NULL;
+	pthread_mutex_unlock(&orphans_lock);
+	if (cache.free[c] != NULL)
+		return;
+
+	size_t object_size = sizeof(union pool_header) + ((size_t) POOL_MIN_SIZE << c);
+	char * slab = malloc(POOL_SLAB_SIZE);		// slabs are kept for the rest of the process, their objects are reused
+	if (slab == NULL)
+		fprintf(stderr, "Error : refill -> malloc\n");
+	assert(slab != NULL);
+	__atomic_add_fetch(&slabs, 1, __ATOMIC_RELAXED);
+
+	for (size_t offset = 0; offset + object_size <= POOL_SLAB_SIZE; offset += object_size)
+	{
+		union pool_header * header = (union pool_header *) (slab + offset);
+		header->next = cache.free[c];
+		cache.free[c] = header;
+	}
+}
+
+void * pool_alloc(size_t size)
+{
+	int c = size_class(size);
+	union pool_header * header;
+	if (c == POOL_CLASSES)
+	{
+		header = malloc(sizeof(union pool_header) + size);
+		if (header == NULL)
+			fprintf(stderr, "Error : pool_alloc -> malloc\n");
+		assert(header != NULL);
+	}
+	else
+	{
+		if (cache.free[c] == NULL)
+			refill(c);
+		header = cache.free[c];
+		cache.free[c] = header->next;
+	}
+	header->size_class = c;
+	__atomic_add_fetch(&live[c], 1, __ATOMIC_RELAXED);
+	return header + 1;
+}
+
+void * pool_calloc(size_t size)
+{
+	void * object = pool_alloc(size);
+	memset(object, 0, size);
+	return object;
+}
+
+void pool_free(void * object)
+{
+	if (object == NULL)
+		return;
+	union pool_header * header = (union pool_header *) object - 1;
+	int c = header->size_class;
+	__atomic_sub_fetch(&live[c], 1, __ATOMIC_RELAXED);
+	if (c == POOL_CLASSES)
+	{
+		free(header);
+		return;
+	}
+	header->next = cache.free[c];
+	cache.free[c] = header;
+}
+
+void pool_stats(long live_objects[POOL_CLASSES + 1], long * slab_count)
+{
+	for (int c = 0; c <= POOL_CLASSES; ++c)
+		live_objects[c] = __atomic_load_n(&live[c], __ATOMIC_RELAXED);
+	*slab_count = __atomic_load_n(&slabs, __ATOMIC_RELAXED);
+}
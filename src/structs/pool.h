@@ -0,0 +1,24 @@
+/*file : pool.h*/
+#pragma once
+#include <stddef.h>
+
+/* pools of small objects by size class (e.g. message bodies, list nodes), so that they are not allocated with malloc one by one : */
+/* each size class has a free list, that is refilled by cutting a slab of POOL_SLAB_SIZE bytes into objects of that class, and a freed */
+/* object goes back to the free list of its class.  The free lists are per thread, so no locks are needed, and an object can be freed */
+/* by any thread of the process (it goes to the list of that thread).  When a thread exits, its free objects are kept for the next */
+/* refills of the other threads.  Objects larger than POOL_MAX_SIZE are allocated with malloc */
+
+#define POOL_CLASSES 8								// size classes of POOL_MIN_SIZE, 2 * POOL_MIN_SIZE, ... bytes
+#define POOL_MIN_SIZE 16
+#define POOL_MAX_SIZE (POOL_MIN_SIZE << (POOL_CLASSES - 1))
+#define POOL_SLAB_SIZE (64 * 1024)
+
+/* returns memory for an object of given size, from the pool of its size class */
+void * pool_alloc(size_t size);
+/* same as pool_alloc, but the memory is set to zero */
+void * pool_calloc(size_t size);
+/* returns given object (allocated by pool_alloc or pool_calloc, or NULL) to its pool */
+void pool_free(void * object);
+/* returns the number of live objects of each size class in the process (live_objects[POOL_CLASSES] is for the objects larger than */
+/* POOL_MAX_SIZE), and the number of slabs allocated */
+void pool_stats(long live_objects[POOL_CLASSES + 1], long * slab_count);
@@ -0,0 +1,244 @@
+/*file : xor_filter.c*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "xor_filter.h"
+#include "bloom.h"
+
+// data struct for xor filter
+struct xor_filter {
+	uint64_t seed;				// mixed with the hash of an object, a new one is tried until the construction succeeds
+	uint32_t block_length;		// the fingerprints are 3 blocks of block_length, an object has one fingerprint in each block
+	uint32_t n;					// number of objects the filter was built from
+	uint32_t bits;				// bits of a fingerprint, 8 or 16
+	void * fingerprints;		// 3 * block_length fingerprints of bits each
+};
+
+/* final mix of murmur3 (fmix64), every bit of x affects every bit of the result */
+static inline uint64_t mix64(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+// rotation by r in [0, 64) : the right shift is masked, as x >> 64 is undefined (r = 0 is the first position)
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> ((64 - r) & 63));
+}
+
+// maps a 32-bit hash to [0, n) with a multiply-shift, instead of a modulo
+static inline uint32_t reduce(uint32_t hash, uint32_t n)
+{
+	return (uint32_t) (((uint64_t) hash * n) >> 32);
+}
+
+static inline uint64_t fingerprint(uint64_t hash)
+{
+	return hash ^ (hash >> 32);
+}
+
+// the i-th (0, 1, 2) position of the object with given (seeded) hash, one in each block
+static inline uint32_t position(uint64_t hash, int i, uint32_t block_length)
+{
+	return reduce((uint32_t) rotl64(hash, 21 * i), block_length) + i * block_length;
+}
+
+static uint32_t block_length(unsigned long n)
+{
+	return (uint32_t) ((32 + 1.23 * n) / 3);
+}
+
+static uint64_t get_fingerprint(XorFilter filter, uint32_t i)
+{
+	return filter->bits == 8 ? ((uint8_t *) filter->fingerprints)[i] : ((uint16_t *) filter->fingerprints)[i];
+}
+
+static void set_fingerprint(XorFilter filter, uint32_t i, uint64_t value)
+{
+	if (filter->bits == 8)
+		((uint8_t *) filter->fingerprints)[i] = (uint8_t) value;
+	else
+		((uint16_t *) filter->fingerprints)[i] = (uint16_t) value;
+}
+
+static int key_compare(const void * a, const void * b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+static XorFilter xor_filter_alloc(uint32_t block_length, uint32_t n, uint32_t bits)
+{
+	XorFilter filter = malloc(sizeof(struct xor_filter));
+	if (filter == NULL)
+		fprintf(stderr, "Error : xor_filter_alloc -> malloc\n");
+	assert(filter != NULL);
+
+	filter->seed = 0;
+	filter->block_length = block_length;
+	filter->n = n;
+	filter->bits = bits;
+	filter->fingerprints = calloc(3 * (size_t) block_length, bits / 8);
+	if (filter->fingerprints == NULL)
+		fprintf(stderr, "Error : xor_filter_alloc -> calloc\n");
+	assert(filter->fingerprints != NULL);
+	return filter;
+}
+
+unsigned int xor_filter_bits(unsigned long n, unsigned int max_size)
+{
+	return 3 * (size_t) block_length(n) * 2 <= max_size ? 16 : 8;
+}
+
+XorFilter xor_filter_build(uint64_t * keys, unsigned int n, unsigned int bits)
+{
+	assert(bits == 8 || bits == 16);
+
+	// the construction needs distinct objects
+	qsort(keys, n, sizeof(uint64_t), key_compare);
+	unsigned int distinct = 0;
+	for (unsigned int i = 0; i < n; i++)
+		if (distinct == 0 || keys[i] != keys[distinct - 1])
+			keys[distinct++] = keys[i];
+	n = distinct;
+
+	uint32_t length = block_length(n), capacity = 3 * length;
+	XorFilter filter = xor_filter_alloc(length, n, bits);
+
+	// each position keeps the number of objects mapped to it and the xor of their hashes, so that a position of a single object
+	// also tells which object it is. Such positions are peeled off (with their object) until none is left, and then the fingerprints
+	// are assigned in the reverse order, each one being the only unassigned position of its object at that point
+	uint64_t * xor_mask = malloc(capacity * sizeof(uint64_t));
+	uint32_t * count = malloc(capacity * sizeof(uint32_t));
+	uint32_t * queue = malloc(capacity * sizeof(uint32_t));
+	uint64_t * stack_hash = malloc(n * sizeof(uint64_t) + 1);
+	uint32_t * stack_position = malloc(n * sizeof(uint32_t) + 1);
+	if (xor_mask == NULL || count == NULL || queue == NULL || stack_hash == NULL || stack_position == NULL)
+		fprintf(stderr, "Error : xor_filter_build -> malloc\n");
+	assert(xor_mask != NULL && count != NULL && queue != NULL && stack_hash != NULL && stack_position != NULL);
+
+	uint64_t seed_state = 0x9e3779b97f4a7c15ULL;
+	unsigned int peeled = 0;
+	while (true)
+	{
+		filter->seed = mix64(seed_state += 0x9e3779b97f4a7c15ULL);		// a fresh seed for each try
+		memset(xor_mask, 0, capacity * sizeof(uint64_t));
+		memset(count, 0, capacity * sizeof(uint32_t));
+		for (unsigned int i = 0; i < n; i++)
+		{
+			uint64_t hash = mix64(keys[i] + filter->seed);
+			for (int j = 0; j < 3; j++)
+			{
+				uint32_t pos = position(hash, j, length);
+				xor_mask[pos] ^= hash;
+				count[pos]++;
+			}
+		}
+
+		uint32_t queue_size = 0;
+		for (uint32_t pos = 0; pos < capacity; pos++)
+			if (count[pos] == 1)
+				queue[queue_size++] = pos;
+
+		peeled = 0;
+		while (queue_size > 0)
+		{
+			uint32_t pos = queue[--queue_size];
+			if (count[pos] != 1)		// its object was already peeled off through another position
+				continue;
+			uint64_t hash = xor_mask[pos];
+			stack_hash[peeled] = hash;
+			stack_position[peeled++] = pos;
+			for (int j = 0; j < 3; j++)
+			{
+				uint32_t other = position(hash, j, length);
+				xor_mask[other] ^= hash;
+				if (--count[other] == 1)
+					queue[queue_size++] = other;
+			}
+		}
+		if (peeled == n)
+			break;
+	}
+
+	while (peeled > 0)
+	{
+		peeled--;
+		uint64_t hash = stack_hash[peeled], value = fingerprint(hash);
+		for (int j = 0; j < 3; j++)		// the fingerprint at stack_position is still zero
+			value ^= get_fingerprint(filter, position(hash, j, length));
+		set_fingerprint(filter, stack_position[peeled], value);
+	}
+
+	free(xor_mask);
+	free(count);
+	free(queue);
+	free(stack_hash);
+	free(stack_position);
+	return filter;
+}
+
+bool xor_filter_check(XorFilter filter, unsigned char * string)
+{
+	if (filter->n == 0)
+		return false;
+	uint64_t hash = mix64(bloom_hash(string) + filter->seed);
+	uint64_t value = fingerprint(hash);
+	for (int j = 0; j < 3; j++)
+		value ^= get_fingerprint(filter, position(hash, j, filter->block_length));
+	return (value & ((1U << filter->bits) - 1)) == 0;
+}
+
+unsigned int xor_filter_count(XorFilter filter)
+{
+	return filter->n;
+}
+
+unsigned int xor_filter_size(XorFilter filter)
+{
+	return XOR_FILTER_HEADER_SIZE + 3 * filter->block_length * (filter->bits / 8);
+}
+
+void xor_filter_write(XorFilter filter, void * dest)
+{
+	memcpy(dest, &filter->seed, sizeof(uint64_t));
+	memcpy(dest + sizeof(uint64_t), &filter->block_length, sizeof(uint32_t));
+	memcpy(dest + sizeof(uint64_t) + sizeof(uint32_t), &filter->n, sizeof(uint32_t));
+	memcpy(dest + sizeof(uint64_t) + 2 * sizeof(uint32_t), &filter->bits, sizeof(uint32_t));
+	memcpy(dest + XOR_FILTER_HEADER_SIZE, filter->fingerprints, 3 * (size_t) filter->block_length * (filter->bits / 8));
+}
+
+XorFilter xor_filter_read(const void * src, unsigned int size)
+{
+	uint64_t seed;
+	uint32_t length, n, bits;
+	if (size < XOR_FILTER_HEADER_SIZE)
+		return NULL;
+	memcpy(&seed, src, sizeof(uint64_t));
+	memcpy(&length, src + sizeof(uint64_t), sizeof(uint32_t));
+	memcpy(&n, src + sizeof(uint64_t) + sizeof(uint32_t), sizeof(uint32_t));
+	memcpy(&bits, src + sizeof(uint64_t) + 2 * sizeof(uint32_t), sizeof(uint32_t));
+	if ((bits != 8 && bits != 16) || length != block_length(n) || size != XOR_FILTER_HEADER_SIZE + 3 * (size_t) length * (bits / 8))
+		return NULL;
+
+	XorFilter filter = xor_filter_alloc(length, n, bits);
+	filter->seed = seed;
+	memcpy(filter->fingerprints, src + XOR_FILTER_HEADER_SIZE, 3 * (size_t) length * (bits / 8));
+	return filter;
+}
+
+void xor_filter_destroy(XorFilter filter)
+{
+	if (filter == NULL)
+		fprintf(stderr, "Error : xor_filter_destroy -> filter is NULL\n");
+	assert(filter != NULL);
+
+	free(filter->fingerprints);
+	free(filter);
+}
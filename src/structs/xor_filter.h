@@ -0,0 +1,31 @@
+/*file : xor_filter.h*/
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/* xor filter : an immutable set of objects, built once from all of them, that answers "maybe in the set" / "definitely not in the set" */
+/* as a bloom filter does, with three memory accesses per lookup and a false positive rate of 1/256 (8-bit fingerprints) or 1/65536 */
+/* (16-bit fingerprints), using about 1.23 fingerprints per object */
+/* objects are given as their bloom_hash, so that a string is checked against a xor filter the same way as against a bloom filter */
+
+#define XOR_FILTER_HEADER_SIZE (sizeof(uint64_t) + 3 * sizeof(uint32_t))	// <uint64_t seed> <uint32_t block_length> <uint32_t n> <uint32_t bits>
+
+typedef struct xor_filter * XorFilter;
+
+/* returns the fingerprint bits (16 or 8) to use for a xor filter of n objects, so that it takes no more than max_size bytes if possible */
+unsigned int xor_filter_bits(unsigned long n, unsigned int max_size);
+/* builds and returns a xor filter of given fingerprint bits (8 or 16) that holds the n objects whose bloom_hash is in keys */
+/* (keys is sorted in place, duplicates are allowed) */
+XorFilter xor_filter_build(uint64_t * keys, unsigned int n, unsigned int bits);
+/* checks if a given object-string is in xor filter */
+bool xor_filter_check(XorFilter filter, unsigned char * string);
+/* returns the number of objects the xor filter was built from */
+unsigned int xor_filter_count(XorFilter filter);
+/* returns the size in bytes of the serialized xor filter (see xor_filter_write) */
+unsigned int xor_filter_size(XorFilter filter);
+/* writes the xor filter into dest (of xor_filter_size bytes) : <header (see XOR_FILTER_HEADER_SIZE)> <fingerprints> */
+void xor_filter_write(XorFilter filter, void * dest);
+/* creates and returns a xor filter from the size bytes written by xor_filter_write at src, returns NULL if they are not a valid xor filter */
+XorFilter xor_filter_read(const void * src, unsigned int size);
+/* deletes xor filter data structure */
+void xor_filter_destroy(XorFilter filter);
@@ -25,15 +25,15 @@ int main(int argc, char const *argv[])
 	}
 
 	int numMonitors, bufferSize;
-	unsigned int bloom_size;
+	unsigned int bloom_size, options, threads;
 	DIR * input_dir;
 	
 	/* check for correct arg input from terminal and initialize program parameters */
-	if (!check_init_args(argc, argv, &numMonitors, &bufferSize, &bloom_size, &input_dir))
+	if (!check_init_args(argc, argv, &numMonitors, &bufferSize, &bloom_size, &options, &threads, &input_dir))
 		exit(EXIT_FAILURE);
 
 	/* initialization phase (part1) */
-	struct travelMonitor * travelMonitor = travelMonitor_init(numMonitors, bufferSize, bloom_size, input_dir);	// initialize structures kept by travelMonitor
+	struct travelMonitor * travelMonitor = travelMonitor_init(numMonitors, bufferSize, bloom_size, options, threads, input_dir);	// initialize structures kept by travelMonitor
 	ipc_init(travelMonitor);    						// create fifos, fork and exec for children Monitors, open the fifos and make them ready for use
 
 	/* initialization phase (part2) */
@@ -63,7 +63,12 @@ int main(int argc, char const *argv[])
 			exit(EXIT_FAILURE);
 		}
 
+		bool more_commands = command_ready();
+		if (!more_commands)		// about to wait on the user, so first complete the travel requests in flight and print their results
+			tm_complete_requests(travelMonitor);
 		printf("Waiting for command/task >>  ");
+		if (!more_commands)
+			fflush(stdout);		// commands are not read through stdio, so the prompt would not get flushed otherwise
 
 		if (tm_unblock_signals() < 0)		// unblock signals 
 		{
@@ -71,7 +76,7 @@ int main(int argc, char const *argv[])
 			exit(EXIT_FAILURE);
 		}
 
-		if (fgets(input, 100, stdin) == NULL && errno == EINTR)		// fgets was interrupted by a signal, so ignore characters read and handle signal first
+		if (read_command(input, 100) == NULL && errno == EINTR)		// read_command was interrupted by a signal, so ignore characters read and handle signal first
 		{
 			printf("\n");
 			continue;
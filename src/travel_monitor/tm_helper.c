@@ -15,17 +15,260 @@
 
 #include "hash.h"
 #include "bloom.h"
+#include "xor_filter.h"
 #include "tm_helper.h"
 #include "tm_items.h"
 #include "messages.h"
+#include "pool.h"
 #include "date.h"
+#include "tm_reactor.h"
 
 #define PERMS 0766
+#define MAX_REQUESTS_IN_FLIGHT 4096		// max number of travel requests whose results have not been printed yet
+#define RECORD_BYTES 48					// typical size of a record in the input files, used to estimate the number of records
+#define SAMPLE_BYTES 16384				// bytes read from the first file of each subdirectory, to sample the records
+#define SAMPLE_VIRUSES 64				// most distinct viruses counted in the sample
 
 
 /*===================== INITIALIZATION PHASE ===========================*/
 
-struct travelMonitor * travelMonitor_init(int numMonitors, int bufferSize, unsigned int bloom_size, DIR * input_dir)
+/* message handlers, called by the reactor for each message read from a Monitor process (see tm_reactor.h) */
+
+// expects just a DONE message from the Monitor
+static int done_handler(struct travelMonitor * tm, int monitor_index, int msgd, void * message, void * arg)
+{
+	if (msgd != DONE)
+	{
+		fprintf(stderr, "[Error] : done_handler -> Unexpected message descriptor\n\n");
+		return -1;
+	}
+	return 1;
+}
+
+struct status_query {		// argument of vaccination_status_handler
+	char * citizenID;		// the citizenID searched for
+	int found;				// 1 if at least one monitor process found given citizenID, 0 otherwise
+};
+
+// expects info about a citizen (MSG6, MSG7) from the Monitor, until it sends DONE. arg points to a struct status_query
+static int vaccination_status_handler(struct travelMonitor * tm, int monitor_index, int msgd, void * message, void * arg)
+{
+	if (msgd == DONE)		// monitor process sent DONE message, that means it is done sending info about citizenID and is ready for other commands
+		return 1;
+
+	if (msgd == MSG6)		// MSG6 means Monitor sent name, surname, country, age about given citizenID
+	{
+		char name[13], surname[13], country[30]; int age;
+		if (decode_msg6(msgd, message, name, surname, country, &age) < 0)
+			return -1;
+		struct status_query * query = arg;
+		query->found = 1;					// at least one monitor process found given citizenID
+		printf("%s %s %s %s\n", query->citizenID, name, surname, country);
+		printf("AGE %d\n", age);
+	}
+	else if (msgd == MSG7)	// MSG7 means Monitor sent vaccination info about given citizenID (virusname, vaccination status, date)
+	{
+		char virus[20] , status[4], date[DATE_STRING_SIZE];
+		unsigned int day;
+		if (decode_msg7(msgd, message, virus, status, &day) < 0)
+			return -1;
+		printf("%s ", virus);
+		date_format(day, date);
+		if (!strcmp(status, "YES"))
+			printf("VACCINATED ON %s\n", date);
+		else
+			printf("NOT YET VACCINATED\n");
+	}
+	else		// otherwise we have an IPC error, which should NEVER occur
+	{
+		fprintf(stderr, "[Error] : searchVaccinationStatus -> Unexpected message descriptor\n\n");
+		return -1;
+	}
+
+	delete_message(message);  	// message is read and decoded, no longer needed
+	return 0;
+}
+
+// expects the bloom filters (MSG2, MSG13 if they are shared, or MSG14 with just the changed words on updates) of the Monitor,
+// or xor filters instead of them (MSG15), until it sends DONE
+static int bloom_filter_handler(struct travelMonitor * tm, int monitor_index, int msgd, void * message, void * arg)
+{
+	if (msgd == DONE)	// Monitor sent DONE, all bloom filters have been updated
+		return 1;
+
+	char virus[20]; int shm_fd; unsigned int generation;
+	TM_VirusInfo virus_info;
+	if (msgd == MSG14)		// only the words that changed, applied in place to the bloom filter the travelMonitor already has
+	{
+		unsigned int runs, first_word, count;
+		void * words;
+		if (decode_msg14(msgd, message, virus, &runs, &words) < 0)
+			return -1;
+		if ((virus_info = hash_search(tm->monitors_info[monitor_index]->viruses_info, virus)) == NULL)
+		{
+			fprintf(stderr, "[Error] : bloom_filter_handler -> update of unknown virus %s\n\n", virus);
+			return -1;
+		}
+		for (unsigned int i = 0; i < runs; i++)
+		{
+			get_msg14_run(message, i, &first_word, &count);
+			if (tm_virus_info_update_words(virus_info, first_word, count, words) < 0)
+				return -1;
+			words += count * BLOOM_WORD_SIZE;
+		}
+		delete_message(message);
+		return 0;
+	}
+	else if (msgd == MSG15)		// a xor filter, that replaces whatever filter the travelMonitor has for the virus
+	{
+		unsigned int length;
+		void * data;
+		if (decode_msg15(msgd, message, virus, &length, &data) < 0)
+			return -1;
+		XorFilter filter = xor_filter_read(data, length);
+		if (filter == NULL)
+		{
+			fprintf(stderr, "[Error] : bloom_filter_handler -> invalid xor filter of virus %s\n\n", virus);
+			return -1;
+		}
+		if ((virus_info = hash_search(tm->monitors_info[monitor_index]->viruses_info, virus)) != NULL)
+			tm_virus_info_update_xor(virus_info, filter);
+		else
+			hash_insert(tm->monitors_info[monitor_index]->viruses_info, tm_virus_info_create_xor(virus, filter));
+		delete_message(message);
+		return 0;
+	}
+	else if (msgd == MSG13)
+	{
+		if (decode_msg13(msgd, message, virus, &shm_fd, &generation) < 0)		// decode message of type MSG13
+			return -1;
+	}
+	else if (decode_msg2(msgd, message, virus) < 0)		// decode message of expected type (MSG2)
+		return -1;
+
+	pid_t pid = tm->monitors_info[monitor_index]->pid;
+	bool blocked = tm->options & OPTION_BLOCKED_BLOOM;
+	virus_info = hash_search(tm->monitors_info[monitor_index]->viruses_info, virus);		// search for the virus of message into Monitors HT of viruses
+	if (virus_info != NULL)		// if found (virus already exists)
+	{
+		// just update the bloom filter of virus (a shared one is only mapped again if the Monitor was replaced)
+		if (msgd == MSG13 && tm_virus_info_update_shared(virus_info, tm->bloom_size, tm->hashes, blocked, pid, shm_fd) < 0)
+			return -1;
+	}
+	else  // if not found (virus is a new virus)
+	{
+		// create new virus_info
+		virus_info = (msgd == MSG13) ? tm_virus_info_create_shared(virus, tm->bloom_size, tm->hashes, blocked, pid, shm_fd) :
+									   tm_virus_info_create(virus, tm->bloom_size, tm->hashes, blocked, NULL);
+		if (virus_info == NULL)
+			return -1;
+		hash_insert(tm->monitors_info[monitor_index]->viruses_info, virus_info);	//update viruses_info HT
+	}
+	// the bit array of MSG2 is decoded straight into the bloom filter of virus
+	if (msgd == MSG2 && get_msg2_bit_array(message, tm_virus_info_bit_array(virus_info, tm->bloom_size, tm->hashes, blocked)) < 0)
+	{
+		fprintf(stderr, "[Error] : bloom_filter_handler -> invalid bloom filter of virus %s\n\n", virus);
+		return -1;
+	}
+
+	delete_message(message);  	// message is read and decoded, no longer needed
+	return 0;
+}
+
+
+// a sample of the records of the input files, to estimate how many of them a bloom filter (of one virus) holds
+struct record_sample {
+	unsigned long records;					// whole records sampled
+	unsigned long vaccinated;				// of them, the ones with "YES"
+	int viruses;							// distinct viruses met (at most SAMPLE_VIRUSES)
+	char names[SAMPLE_VIRUSES][32];
+};
+
+// adds the whole records in the first SAMPLE_BYTES bytes of given file (of directory dir_fd) to sample
+static void sample_file(int dir_fd, const char * name, struct record_sample * sample)
+{
+	int fd = openat(dir_fd, name, O_RDONLY);
+	if (fd < 0)
+		return;
+	char buffer[SAMPLE_BYTES + 1];
+	ssize_t length = read(fd, buffer, SAMPLE_BYTES);
+	close(fd);
+	while (length > 0 && buffer[length - 1] != '\n')		// the last record may be cut
+		length--;
+	buffer[length > 0 ? length : 0] = '\0';
+
+	char * save_line;
+	for (char * line = strtok_r(buffer, "\n", &save_line); line != NULL; line = strtok_r(NULL, "\n", &save_line))
+	{
+		// citizenID firstName lastName country age virusName YES/NO [date]
+		char * fields[7];
+		char * save_field;
+		int count = 0;
+		for (char * field = strtok_r(line, " \t\r", &save_field); field != NULL && count < 7; field = strtok_r(NULL, " \t\r", &save_field))
+			fields[count++] = field;
+		if (count < 7)
+			continue;
+		sample->records++;
+		if (!strcmp(fields[6], "YES"))
+			sample->vaccinated++;
+		int i = 0;
+		while (i < sample->viruses && strcmp(sample->names[i], fields[5]))
+			i++;
+		if (i == sample->viruses && i < SAMPLE_VIRUSES)
+		{
+			snprintf(sample->names[i], sizeof(sample->names[i]), "%s", fields[5]);
+			sample->viruses++;
+		}
+	}
+}
+
+// estimates how many citizens a bloom filter of a Monitor holds : a filter keeps the vaccinated citizens of one virus, so the share of
+// the records of a Monitor (estimated from the sizes of the files) is split by the vaccinated records and the viruses of a sample
+static unsigned long estimate_filter_records(DIR * input_dir, int monitors)
+{
+	unsigned long bytes = 0;
+	struct record_sample sample;
+	sample.records = 0;
+	sample.vaccinated = 0;
+	sample.viruses = 0;
+	struct dirent * subdir;
+	rewinddir(input_dir);
+	while ((subdir = readdir(input_dir)) != NULL)
+	{
+		if (!strcmp(subdir->d_name, ".") || !strcmp(subdir->d_name, ".."))
+			continue;
+		int fd = openat(dirfd(input_dir), subdir->d_name, O_RDONLY | O_DIRECTORY);
+		DIR * dir;
+		if (fd < 0 || (dir = fdopendir(fd)) == NULL)
+		{
+			if (fd >= 0)
+				close(fd);
+			continue;
+		}
+		struct dirent * file;
+		struct stat st;
+		bool sampled = false;
+		while ((file = readdir(dir)) != NULL)
+			if (fstatat(fd, file->d_name, &st, 0) == 0 && S_ISREG(st.st_mode))
+			{
+				bytes += st.st_size;
+				if (!sampled)		// one file per subdirectory, so that every country is in the sample
+					sample_file(fd, file->d_name, &sample);
+				sampled = true;
+			}
+		closedir(dir);		// closes fd as well
+	}
+	rewinddir(input_dir);
+
+	if (monitors == 0 || bytes == 0)		// nothing to read (e.g. an empty input_dir)
+		return 0;
+	unsigned long records = bytes / RECORD_BYTES / monitors;
+	if (sample.records == 0)		// nothing to sample, assume every record may be in one filter
+		return records;
+	return (unsigned long) ((double) records * sample.vaccinated / sample.records / sample.viruses);
+}
+
+struct travelMonitor * travelMonitor_init(int numMonitors, int bufferSize, unsigned int bloom_size, unsigned int options, unsigned int threads, DIR * input_dir)
 {
 	struct travelMonitor * tm = malloc(sizeof(struct travelMonitor));
 	if (tm == NULL)
@@ -53,6 +296,10 @@ struct travelMonitor * travelMonitor_init(int numMonitors, int bufferSize, unsig
 
 	tm->bufferSize = bufferSize;
 	tm->bloom_size = bloom_size;
+	tm->options = options;
+	tm->threads = threads;
+	// the bloom filters are expected to hold the vaccinated citizens of one virus, out of the share of the records of a Monitor
+	tm->hashes = bloom_optimal_k(bloom_size, estimate_filter_records(input_dir, tm->numMonitors), BLOOM_FP_RATE);
 	tm->accepted = 0;
 	tm->rejected = 0;
 	
@@ -67,10 +314,15 @@ struct travelMonitor * travelMonitor_init(int numMonitors, int bufferSize, unsig
 		if (tm->monitors_info[i] == NULL)
 			fprintf(stderr, "Error : travelMonitor_init -> malloc \n");
 		assert(tm->monitors_info[i] != NULL);
-		tm->monitors_info[i]->viruses_info = hash_create(10, 4);	// create the hash_table of viruses_info (virus name, bloom filter) for travelMonitor
+		tm->monitors_info[i]->viruses_info = hash_create(10, (HashKey) tm_get_virus_name, (HashDestroy) tm_virus_info_destroy);	// create the hash_table of viruses_info (virus name, bloom filter) for travelMonitor
 	}	
 
-	tm->countries_info = hash_create(10, 5);				// create the hash_table of countries_info (country name, monitor index) for travelMonitor
+	tm->countries_info = hash_create(10, (HashKey) tm_get_country_name, (HashDestroy) tm_country_info_destroy);	// create the hash_table of countries_info (country name, monitor index) for travelMonitor
+	tm->travel_stats = hash_create(8, (HashKey) tm_get_travel_stats_virus, (HashDestroy) tm_travel_stats_destroy);
+	tm->epoll_fd = tm_reactor_create();					// create the epoll instance, where the read/write fds of the monitors will be registered
+	tm->waiting_monitors = 0;
+	tm->requests_in_flight = 0;
+	tm->requests = tm_requests_create();				// no travel requests made yet
 	bloomSize_init(bloom_size);			// initialize bloomSize for messages.c
 
 	return tm;
@@ -124,63 +376,19 @@ void ipc_init(struct travelMonitor * tm)
 				perror("[Error] : ipc_init -> open (for read)\n");
 				exit(EXIT_FAILURE);
 			}
+
+			tm_reactor_add(tm, i);		// create the connection to the monitor and register it to the epoll instance
 		}
 	}
 
 	for (int i = 0; i < tm->numMonitors; ++i)		// for each Monitor process just created
 	{
-		void * message = create_msg0(tm->bufferSize, tm->bloom_size);		
-		send_message(tm->monitors_info[i]->write_fd, MSG0, message, tm->bufferSize);	// send the bufferSize and the bloom size as the first message
+		void * message = create_msg0(tm->bufferSize, tm->bloom_size, tm->options, tm->hashes, tm->threads);		
+		tm_reactor_send(tm, i, MSG0, message);		// send the bufferSize and the bloom size as the first message
 	}
 
-	int ready_monitors = 0;
-	fd_set readfds;
-	
-	int is_set[tm->numMonitors];				// keeps track of which child monitor processes have been dealt with (have sent DONE)
-	for (int i = 0; i < tm->numMonitors; ++i)
-		is_set[i] = 0;							// initially all read fd are not set
-
-	while (ready_monitors != tm->numMonitors)	// repeat until all child monitor processes info has been read by travelMonitor
-	{
-		FD_ZERO(&readfds);						// reinitialize the set of read fds to wait on
-		int max_fd = 0;
-		
-		for (int i = 0; i < tm->numMonitors; ++i)
-		{
-			if (!is_set[i])
-			{
-				FD_SET(tm->monitors_info[i]->read_fd, &readfds);			// each iteration we set the read fds not yet set
-				if (tm->monitors_info[i]->read_fd > max_fd)
-					max_fd = tm->monitors_info[i]->read_fd;				// find max file descriptor for first arg in select
-			}
-		}
-
-		if (select(max_fd + 1, &readfds, NULL, NULL, NULL) < 0)
-		{
-			perror("[Error] : ipc_init -> select\n");
-			exit(EXIT_FAILURE);
-		}
-
-		for (int i = 0; i < tm->numMonitors; ++i)
-		{
-			if (!is_set[i])		// we only care for those read fd not yet set (still pending)
-			{
-				if(FD_ISSET(tm->monitors_info[i]->read_fd, &readfds))		// if readfd was set this time (we can safely read without fear of blocking - there is data in the read end of pipe)
-				{	
-					int msgd;
-					read_message(tm->monitors_info[i]->read_fd, &msgd, tm->bufferSize);	// read response message from Monitor (should be a DONE message)
-					if (msgd != DONE)
-					{
-						fprintf(stderr, "[Error] : ipc_init -> Unexpected message descriptor\n\n");
-						exit(EXIT_FAILURE);						
-					}
-					
-					ready_monitors += 1;
-					is_set[i] = 1;			// readfd has finally been set, don't worry about it no more
-				}
-			}
-		}
-	}
+	tm_reactor_expect_all(tm);
+	tm_reactor_wait(tm, done_handler, NULL);		// wait until every Monitor replies with a DONE message
 }
 
 void assign_subdirs(struct travelMonitor * tm, DIR * input_dir, const char * input_dir_name)
@@ -206,7 +414,7 @@ void assign_subdirs(struct travelMonitor * tm, DIR * input_dir, const char * inp
 		else
 		{
 			void * message = create_msg1(input_dir_name, subdir_list[i]->d_name);								// construct message
-			send_message(tm->monitors_info[monitor_index]->write_fd, MSG1, message, tm->bufferSize);	// send message
+			tm_reactor_send(tm, monitor_index, MSG1, message);										// send message
 			TM_CountryInfo country_info = tm_country_info_create(subdir_list[i]->d_name, monitor_index);	// new subdir means a new country, so create a new country_info struct
 			hash_insert(tm->countries_info, country_info);				// insert the new country_info into the countries_info hashtable of travelMonitor
 			monitor_index = (monitor_index + 1) % tm->numMonitors;		// subdirectories are assigned to Monitor processes using alphabetical round-robin scheme
@@ -219,79 +427,81 @@ void assign_subdirs(struct travelMonitor * tm, DIR * input_dir, const char * inp
 
     // after assigning all subdirectories to the Monitor processes, notify them you are DONE sending subdirectories and you expect back the bloom filters
     for (int i = 0; i < tm->numMonitors; ++i)
-    	send_message(tm->monitors_info[i]->write_fd, DONE, NULL, tm->bufferSize);
+    	tm_reactor_send(tm, i, DONE, NULL);
 
     closedir(input_dir);			// input_dir is no longer needed
 }
 
 void wait_monitors_bfs(struct travelMonitor * tm)
 {
-	int ready_monitors = 0;
-	fd_set readfds;
-	
-	int is_set[tm->numMonitors];					// keeps track of which child monitor processes have been dealt with (parent has read ALL their bloom filters)
-	for (int i = 0; i < tm->numMonitors; ++i)
-		is_set[i] = 0;							// initially all read fd are not set
+	tm_reactor_expect_all(tm);
+	tm_reactor_wait(tm, bloom_filter_handler, NULL);		// repeat until all child monitor processes info has been read by travelMonitor
+}
 
-	while (ready_monitors != tm->numMonitors)	// repeat until all child monitor processes info has been read by travelMonitor
-	{
-		FD_ZERO(&readfds);						// reinitialize the set of read fds to wait on
-		int max_fd = 0;
-		
-		for (int i = 0; i < tm->numMonitors; ++i)
-		{
-			if (!is_set[i])
-			{
-				FD_SET(tm->monitors_info[i]->read_fd, &readfds);			// each iteration we set the read fds not yet set
-				if (tm->monitors_info[i]->read_fd > max_fd)
-					max_fd = tm->monitors_info[i]->read_fd;				// find max file descriptor for first arg in select
-			}
-		}
 
-		if (select(max_fd + 1, &readfds, NULL, NULL, NULL) < 0)
-		{
-			perror("[Error] : wait_monitors_bfs -> select\n");
-			exit(EXIT_FAILURE);
-		}
+/* =================== QUERY PHASE ========================= */
 
-		for (int i = 0; i < tm->numMonitors; ++i)
+// saves the result of a travel request, in the stats of countryTo and in the stats of all countries
+static void save_travel_request(struct travelMonitor * tm, TM_CountryInfo countryTo, unsigned int date, char * virus, int result)
+{
+	tm_country_add_travelRequest(countryTo, date, virus, result);
+	tm_travel_stats_add(tm->travel_stats, date, virus, result);
+}
+
+// the result of given request is known, so update the stats and notify the Monitor process that handles countryTo
+static void resolve_request(struct travelMonitor * tm, struct tm_request * request)
+{
+	int result = (request->verdict == REQUEST_ACCEPTED);
+	if (result)
+		tm->accepted += 1;
+	else
+		tm->rejected += 1;
+
+	int monitor_index_to = tm_get_country_monitor(request->countryTo);		// get the index of monitor that "watches" the specific countryTo
+	void * message = create_msg8(result);		// construct message
+	// send message, its reply (should be a DONE message) is handled by tm_request_complete
+	tm_reactor_send_request(tm, monitor_index_to, MSG8, request->req_id, message);
+
+	save_travel_request(tm, request->countryTo, request->date, request->virus, result);
+}
+
+// prints the results of the oldest requests that have one, in the order the requests were made, and removes them
+static void retire_requests(struct travelMonitor * tm)
+{
+	struct tm_request * request;
+	while ((request = tm_requests_oldest(tm->requests)) != NULL && request->verdict != REQUEST_PENDING)
+	{
+		switch (request->verdict)
 		{
-			if (!is_set[i])		// we only care for those read fd not yet set (still pending)
-			{
-				if(FD_ISSET(tm->monitors_info[i]->read_fd, &readfds))		// if readfd was set this time (we can safely read without fear of blocking - there is data in the read end of pipe)
-				{	
-					int msgd;
-					void * message = read_message(tm->monitors_info[i]->read_fd, &msgd, tm->bufferSize);	//read message data and its header-msgd
-					if (msgd != DONE)	// if message still has data (has not sent DONE msgd yet)
-					{
-						char virus[20]; void * bit_array;
-						if (decode_msg2(msgd, message, virus, &bit_array) < 0)		// decode message of expected type (MSG2) 	
-							exit(EXIT_FAILURE);
-						TM_VirusInfo virus_info = tm_virus_info_create(virus, tm->bloom_size, bit_array);
-						hash_insert(tm->monitors_info[i]->viruses_info, virus_info);	//update viruses_info HT
-						delete_message(message);  	// message is read and decoded, no longer needed
-					}
-					else	// monitor process sent DONE message, that means it is done sending bloom filters and is ready for commands
-					{
-						ready_monitors += 1;
-						is_set[i] = 1;			// readfd has finally been set, don't worry about it no more
-					}
-				}
-			}
+			case REQUEST_NOT_VACCINATED:
+				printf("REQUEST REJECTED - YOU ARE NOT VACCINATED\n\n");
+				break;
+			case REQUEST_NEEDS_VACCINATION:
+				printf("REQUEST REJECTED - YOU WILL NEED ANOTHER VACCINATION BEFORE TRAVEL DATE\n\n");
+				break;
+			case REQUEST_VACCINATED_AFTER:
+				printf("REQUEST REJECTED - YOU ARE NOT VACCINATED (VACCINATION FOUND BUT IS AFTER THE TRAVEL DATE)\n\n");
+				break;
+			case REQUEST_ACCEPTED:
+				printf("REQUEST ACCEPTED - HAPPY TRAVELS\n\n");
+				break;
+			case REQUEST_FAILED:
+				fprintf(stderr, "[Error] : travelRequest -> Monitor process did not answer, request could not be completed\n\n");
+				break;
 		}
+		tm_requests_remove_oldest(tm->requests);
 	}
 }
 
-
-/* =================== QUERY PHASE ========================= */
-
-void travelRequest(struct travelMonitor * tm, char * citizenID, char * date, char * countryFrom, char * countryTo, char * virusName)
+// checks the arguments of a travel request, if they are valid returns 1, the date as a day number, the info of countryTo, the index of
+// the monitor that "watches" countryFrom and the info (bloom filter) of given virus for that monitor, otherwise prints what is wrong and returns 0
+static int check_travel_request(struct travelMonitor * tm, char * citizenID, char * date, char * countryFrom, char * countryTo, char * virusName,
+								unsigned int * day, TM_CountryInfo * countryTo_info, int * monitor_index, TM_VirusInfo * virus_info)
 {
-	int result;
-	if (!date_check(date))
+	if ((*day = date_parse(date)) == DATE_NONE)
 	{
 		fprintf(stderr, "[Error] : travelRequest -> Invalid date\n\n");
-		return;
+		return 0;
 	}
 
 	for (int i = 0; i < strlen(citizenID); i++)	// check for an integer citizenID
@@ -299,14 +509,14 @@ void travelRequest(struct travelMonitor * tm, char * citizenID, char * date, cha
 		if (citizenID[i] < '0' || citizenID[i] > '9')
 		{
 			fprintf(stderr, "[Error] : travelRequest -> CitizenID is not a string of numbers\n\n");
-			return;
+			return 0;
 		}
 	}
 
 	if (strlen(citizenID) > 5)
 	{
 		fprintf(stderr, "[Error] : travelRequest -> CitizenID has at most 5 digits\n\n");
-		return;
+		return 0;
 	}
 
 	// search for the country countryFrom in the HT of countries of travelMonitor
@@ -314,85 +524,339 @@ void travelRequest(struct travelMonitor * tm, char * citizenID, char * date, cha
 	if (countryFrom_info == NULL)
 	{
 		fprintf(stderr, "[Error] : travelRequest -> Given countryFrom does not exist in travelMonitor's database\n\n");
-		return;
+		return 0;
 	}
 
 	// search for the country countryTo in the HT of countries of travelMonitor
-	TM_CountryInfo countryTo_info = (TM_CountryInfo) hash_search(tm->countries_info, countryTo);
-	if (countryTo_info == NULL)
+	*countryTo_info = (TM_CountryInfo) hash_search(tm->countries_info, countryTo);
+	if (*countryTo_info == NULL)
 	{
 		fprintf(stderr, "[Error] : travelRequest -> Given countryTo does not exist in travelMonitor's database\n\n");
-		return;
+		return 0;
 	}
 
-	int monitor_index = tm_get_country_monitor(countryFrom_info);		// get the index of monitor that "watches" the specific countryFrom
-	int monitor_index_to = tm_get_country_monitor(countryTo_info);		// get the index of monitor that "watches" the specific countryTo
+	*monitor_index = tm_get_country_monitor(countryFrom_info);		// get the index of monitor that "watches" the specific countryFrom
 	// search for given virusName in the viruses HT of countryFrom of travelMonitor
-	TM_VirusInfo virus_info = (TM_VirusInfo) hash_search(tm->monitors_info[monitor_index]->viruses_info, virusName);
-	if (virus_info == NULL)
+	*virus_info = (TM_VirusInfo) hash_search(tm->monitors_info[*monitor_index]->viruses_info, virusName);
+	if (*virus_info == NULL)
 	{
 		fprintf(stderr, "[Error] : travelRequest -> Given virus is not checked in given countryFrom\n\n");
 		/* TODO maybe consider this an rejected request as well */
-		return;
+		return 0;
 	}
 
-	if (!bloom_check(tm_get_bloom_filter(virus_info), (unsigned char *) citizenID))
+	return 1;
+}
+
+// returns the verdict of a travel request on given date, from the answer (YES/NO) of the Monitor and the date of vaccination
+static int travel_verdict(char * answer, unsigned int vacc_date, unsigned int date)
+{
+	if (!strcmp(answer, "NO"))
+		return REQUEST_NOT_VACCINATED;
+	else if (!date_half_year_check(vacc_date, date))
+		return REQUEST_NEEDS_VACCINATION;
+	else if (date_half_year_check(vacc_date, date) < 0)
+		return REQUEST_VACCINATED_AFTER;
+	else
+		return REQUEST_ACCEPTED;
+}
+
+void travelRequest(struct travelMonitor * tm, char * citizenID, char * date, char * countryFrom, char * countryTo, char * virusName)
+{
+	TM_CountryInfo countryTo_info; int monitor_index; TM_VirusInfo virus_info; unsigned int day;
+	if (!check_travel_request(tm, citizenID, date, countryFrom, countryTo, virusName, &day, &countryTo_info, &monitor_index, &virus_info))
+		return;
+
+	while (tm_requests_count(tm->requests) >= MAX_REQUESTS_IN_FLIGHT && tm->requests_in_flight)		// too many requests in flight, wait for some answers first
+		tm_reactor_poll(tm, -1);
+
+	struct tm_request * request = tm_requests_add(tm->requests);		// the request is now in flight, until its result is printed
+	request->date = day;
+	strcpy(request->virus, virusName);
+	request->countryTo = countryTo_info;
+	request->monitor = monitor_index;
+
+	if (!tm_virus_info_check(virus_info, (unsigned char *) citizenID))
 	{
-		printf("REQUEST REJECTED - YOU ARE NOT VACCINATED\n\n");
-		tm->rejected += 1; result = 0;
+		request->verdict = REQUEST_NOT_VACCINATED;
+		resolve_request(tm, request);
 	}
 	else	// bloom filter replied with MAYBE so send query to Monitor process to find out for sure
 	{
 		void * message = create_msg3(citizenID, virusName);							// construct message
-		send_message(tm->monitors_info[monitor_index]->write_fd, MSG3, message, tm->bufferSize);	// send message	
-		int msgd;
-		void * response_msg = read_message(tm->monitors_info[monitor_index]->read_fd, &msgd, tm->bufferSize);	//read response message from Monitor process
-		char answer[4], vacc_date[12];
-		if (decode_msg4(msgd, response_msg, answer, vacc_date) < 0)		// decode message of expected type (MSG4)
-			exit(EXIT_FAILURE);
-		if (!strcmp(answer, "NO"))	
+		// send message, the answer is handled by tm_request_complete when it arrives
+		if (tm_reactor_send_request(tm, monitor_index, MSG3, request->req_id, message) < 0)
+			request->verdict = REQUEST_FAILED;
+	}
+
+	tm_reactor_poll(tm, 0);		// handle any answers that have already arrived, without blocking
+	retire_requests(tm);
+}
+
+struct batch_request {			// a travel request of a batch
+	char citizenID[6];
+	unsigned int date;			// a day number (see date.h)
+	char virus[21];
+	TM_CountryInfo countryTo;	// the country of destination
+	int monitor;				// index of the Monitor of countryFrom
+	TM_VirusInfo virus_info;	// the virus info (bloom or xor filter) of that Monitor
+	int slot;					// position of the request in the batch sent to that Monitor
+	int verdict;
+};
+
+struct bloom_batch {			// a request of a batch, to be checked together with the rest of the requests of its filter
+	TM_VirusInfo virus_info;
+	int request;				// index of the request in the batch
+};
+
+// orders by filter (virus info), and then by position in the batch
+static int bloom_batch_compare(const void * a, const void * b)
+{
+	const struct bloom_batch * x = a, * y = b;
+	if (x->virus_info != y->virus_info)
+		return ((uintptr_t) x->virus_info < (uintptr_t) y->virus_info) ? -1 : 1;
+	return x->request - y->request;
+}
+
+struct batch_replies {			// argument of batch_answer_handler
+	int * count;				// number of requests in the batch sent to each Monitor
+	void ** reply;				// the reply (MSG11) of each Monitor
+};
+
+// expects the answers (MSG11) of the Monitor to a batch of travel requests. arg points to a struct batch_replies
+static int batch_answer_handler(struct travelMonitor * tm, int monitor_index, int msgd, void * message, void * arg)
+{
+	struct batch_replies * replies = arg;
+	int count;
+	if (decode_msg11(msgd, message, &count) < 0)		// decode message of expected type (MSG11)
+		return -1;
+	if (count != replies->count[monitor_index])
+	{
+		fprintf(stderr, "[Error] : batch_answer_handler -> Monitor answered %d requests instead of %d\n\n", count, replies->count[monitor_index]);
+		return -1;
+	}
+	replies->reply[monitor_index] = message;		// answers are read once all Monitors have replied
+	return 1;
+}
+
+void travelRequestBatch(struct travelMonitor * tm, char * file_name)
+{
+	FILE * file = fopen(file_name, "r");
+	if (file == NULL)
+	{
+		fprintf(stderr, "[Error] : travelRequestBatch -> Could not open given file\n\n");
+		return;
+	}
+	tm_complete_requests(tm);		// results of earlier travel requests are printed first
+
+	int capacity = 1024, size = 0;
+	struct batch_request * requests = malloc(capacity * sizeof(struct batch_request));
+	int * count = calloc(tm->numMonitors, sizeof(int));			// number of requests sent to each Monitor
+	void ** batch = calloc(tm->numMonitors, sizeof(void *));	// the batch (MSG10) sent to each Monitor
+	void ** reply = calloc(tm->numMonitors, sizeof(void *));	// and its reply (MSG11)
+	int * accepted_to = calloc(tm->numMonitors, sizeof(int));	// number of requests accepted/rejected for the countries of each Monitor
+	int * rejected_to = calloc(tm->numMonitors, sizeof(int));
+	if (requests == NULL || count == NULL || batch == NULL || reply == NULL || accepted_to == NULL || rejected_to == NULL)
+		fprintf(stderr, "Error : travelRequestBatch -> malloc\n");
+	assert(requests != NULL && count != NULL && batch != NULL && reply != NULL && accepted_to != NULL && rejected_to != NULL);
+
+	/* first all the requests of the file are read and checked */
+	char line[256];
+	int line_number = 0;
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		line_number += 1;
+		char * args[5];
+		int i = 0;
+		for (char * str = strtok(line, " \t\n"); str != NULL; str = strtok(NULL, " \t\n"), i++)
 		{
-			printf("REQUEST REJECTED - YOU ARE NOT VACCINATED\n\n");
-			tm->rejected += 1; result = 0;
+			if (i < 5)
+				args[i] = str;
 		}
-		else if (!strcmp(answer, "YES") && !date_half_year_check(vacc_date, date))
+		if (i == 0)		// empty line
+			continue;
+
+		TM_CountryInfo countryTo_info; int monitor_index; TM_VirusInfo virus_info; unsigned int day;
+		if (i != 5 || !check_travel_request(tm, args[0], args[1], args[2], args[3], args[4], &day, &countryTo_info, &monitor_index, &virus_info))
 		{
-			printf("REQUEST REJECTED - YOU WILL NEED ANOTHER VACCINATION BEFORE TRAVEL DATE\n\n");
-			tm->rejected += 1; result = 0;
+			fprintf(stderr, "[Error] : travelRequestBatch -> Invalid travel request at line %d, skipped\n\n", line_number);
+			continue;
 		}
-		else if (!strcmp(answer, "YES") && date_half_year_check(vacc_date, date) < 0)
+
+		if (size == capacity)
 		{
-			printf("REQUEST REJECTED - YOU ARE NOT VACCINATED (VACCINATION FOUND BUT IS AFTER THE TRAVEL DATE)\n\n");
-			tm->rejected += 1; result = 0;	
+			capacity *= 2;
+			requests = realloc(requests, capacity * sizeof(struct batch_request));
+			if (requests == NULL)
+				fprintf(stderr, "Error : travelRequestBatch -> realloc\n");
+			assert(requests != NULL);
 		}
-		else if (!strcmp(answer, "YES") && date_half_year_check(vacc_date, date))
+		struct batch_request * request = &requests[size++];
+		strcpy(request->citizenID, args[0]);
+		request->date = day;
+		strcpy(request->virus, args[4]);
+		request->countryTo = countryTo_info;
+		request->monitor = monitor_index;
+		request->virus_info = virus_info;
+	}
+	fclose(file);
+
+	/* then the filters are checked for all requests, each filter for all its requests at once (tm_virus_info_check_many) */
+	struct bloom_batch * order = malloc(size * sizeof(struct bloom_batch));
+	unsigned char ** ids = malloc(size * sizeof(unsigned char *));
+	bool * maybe = malloc(size * sizeof(bool));
+	if (size > 0 && (order == NULL || ids == NULL || maybe == NULL))
+		fprintf(stderr, "Error : travelRequestBatch -> malloc\n");
+	assert(size == 0 || (order != NULL && ids != NULL && maybe != NULL));
+	for (int i = 0; i < size; ++i)
+	{
+		order[i].virus_info = requests[i].virus_info;
+		order[i].request = i;
+	}
+	qsort(order, size, sizeof(struct bloom_batch), bloom_batch_compare);		// the requests of each filter are next to each other
+	for (int first = 0, last; first < size; first = last)
+	{
+		for (last = first; last < size && order[last].virus_info == order[first].virus_info; ++last)
+			ids[last] = (unsigned char *) requests[order[last].request].citizenID;
+		tm_virus_info_check_many(order[first].virus_info, ids + first, last - first, maybe + first);
+	}
+
+	/* and the ones that get a MAYBE are grouped by Monitor, in the order of the file */
+	for (int i = 0; i < size; ++i)
+		requests[order[i].request].verdict = maybe[i] ? REQUEST_PENDING : REQUEST_NOT_VACCINATED;
+	for (int i = 0; i < size; ++i)
+		if (requests[i].verdict == REQUEST_PENDING)
+			requests[i].slot = count[requests[i].monitor]++;
+	free(order);
+	free(ids);
+	free(maybe);
+
+	/* each Monitor gets one message with all its queries, and replies with one message with all the answers */
+	for (int i = 0; i < size; ++i)
+	{
+		if (requests[i].verdict != REQUEST_PENDING)
+			continue;
+		if (batch[requests[i].monitor] == NULL)
+			batch[requests[i].monitor] = create_msg10(count[requests[i].monitor]);
+		set_msg10_query(batch[requests[i].monitor], requests[i].slot, requests[i].citizenID, requests[i].virus);
+	}
+	for (int i = 0; i < tm->numMonitors; ++i)
+	{
+		if (batch[i] == NULL)
+			continue;
+		tm_reactor_send(tm, i, MSG10, batch[i]);		// send message
+		tm_reactor_expect(tm, i);
+	}
+	struct batch_replies replies = { count, reply };
+	tm_reactor_wait(tm, batch_answer_handler, &replies);		// read the answers of all Monitors asked
+
+	/* now the results of all requests are known */
+	int accepted = 0, rejected = 0, failed = 0;
+	for (int i = 0; i < size; ++i)
+	{
+		struct batch_request * request = &requests[i];
+		if (request->verdict == REQUEST_PENDING)
 		{
-			printf("REQUEST ACCEPTED - HAPPY TRAVELS\n\n");
-			tm->accepted += 1; result = 1;
+			if (reply[request->monitor] == NULL)		// Monitor hung up before it answered
+			{
+				failed += 1;
+				continue;
+			}
+			char answer[4];
+			unsigned int vacc_date;
+			get_msg11_answer(reply[request->monitor], request->slot, answer, &vacc_date);
+			request->verdict = travel_verdict(answer, vacc_date, request->date);
 		}
 
-		delete_message(response_msg);		// no longer need message
+		int result = (request->verdict == REQUEST_ACCEPTED);
+		int monitor_index_to = tm_get_country_monitor(request->countryTo);
+		if (result)
+		{
+			accepted += 1;
+			accepted_to[monitor_index_to] += 1;
+		}
+		else
+		{
+			rejected += 1;
+			rejected_to[monitor_index_to] += 1;
+		}
+		save_travel_request(tm, request->countryTo, request->date, request->virus, result);
 	}
+	tm->accepted += accepted;
+	tm->rejected += rejected;
 
-	// notify Monitor process that handles countryTo, whether the request got accepted or rejected
-	void * message = create_msg8(result);		// construct message
-	send_message(tm->monitors_info[monitor_index_to]->write_fd, MSG8, message, tm->bufferSize);	// send message
-	int msgd;
-	read_message(tm->monitors_info[monitor_index_to]->read_fd, &msgd, tm->bufferSize);		// read response message (should be a DONE message)
-	if (msgd != DONE)
+	// notify each Monitor process that handles countries of destination, how many requests got accepted or rejected
+	for (int i = 0; i < tm->numMonitors; ++i)
 	{
-		fprintf(stderr, "[Error] : travelRequest -> Unexpected message descriptor\n\n");
-		exit(EXIT_FAILURE);						
+		if (accepted_to[i] + rejected_to[i] == 0)
+			continue;
+		void * message = create_msg12(accepted_to[i], rejected_to[i]);		// construct message
+		tm_reactor_send(tm, i, MSG12, message);		// send message
+		tm_reactor_expect(tm, i);
 	}
+	tm_reactor_wait(tm, done_handler, NULL);		// read response messages (should be DONE messages)
+
+	if (failed)
+		fprintf(stderr, "[Error] : travelRequestBatch -> Monitor process did not answer, %d requests could not be completed\n\n", failed);
+	printf("TOTAL REQUESTS %d\n", accepted + rejected);		// print stats
+	printf("ACCEPTED %d\n", accepted);
+	printf("REJECTED %d\n\n", rejected);
 
-	tm_country_add_travelRequest(countryTo_info, date, virusName, result);		// save the travel Request for the countryTo
+	for (int i = 0; i < tm->numMonitors; ++i)
+		delete_message(reply[i]);
+	free(requests); free(count); free(batch); free(reply); free(accepted_to); free(rejected_to);
+}
+
+int tm_request_complete(struct travelMonitor * tm, int monitor_index, int msgd, int req_id, void * message)
+{
+	if (msgd == DONE)		// Monitor of countryTo got notified about the result of the request (see resolve_request)
+		return 0;
+
+	struct tm_request * request = tm_requests_get(tm->requests, req_id);
+	if (request == NULL || request->verdict != REQUEST_PENDING)
+	{
+		fprintf(stderr, "[Error] : tm_request_complete -> Reply to unknown request %d\n\n", req_id);
+		return -1;
+	}
+
+	char answer[4];
+	unsigned int vacc_date;
+	if (decode_msg4(msgd, message, answer, &vacc_date) < 0)		// decode message of expected type (MSG4)
+		return -1;
+	delete_message(message);		// no longer need message
+
+	request->verdict = travel_verdict(answer, vacc_date, request->date);
+
+	resolve_request(tm, request);
+	retire_requests(tm);
+	return 0;
+}
+
+void tm_requests_fail(struct travelMonitor * tm, int monitor_index)
+{
+	struct tm_request * request;
+	for (int i = 0; (request = tm_requests_at(tm->requests, i)) != NULL; ++i)
+	{
+		if (request->monitor == monitor_index && request->verdict == REQUEST_PENDING)
+			request->verdict = REQUEST_FAILED;
+	}
+	retire_requests(tm);
+}
+
+void tm_complete_requests(struct travelMonitor * tm)
+{
+	while (tm->requests_in_flight)		// all answers (and the DONE replies of the Monitors of countryTo)
+		tm_reactor_poll(tm, -1);
+	retire_requests(tm);
 }
 
 void travelStats(struct travelMonitor * tm, char * virusName, char * date1, char * date2, char * country)
 {
 	int rejected = 0, accepted = 0;
+	tm_complete_requests(tm);		// stats should include all travel requests made so far
 
-	if (!date_check(date1) || !date_check(date2) || date_cmp(date1, date2) > 0 )	// check for valid dates
+	unsigned int day1 = date_parse(date1), day2 = date_parse(date2);
+	if (day1 == DATE_NONE || day2 == DATE_NONE || day1 > day2)	// check for valid dates
 	{
 		fprintf(stderr, "Error : travelStats -> Invalid dates\n\n");
 		return;
@@ -408,21 +872,14 @@ void travelStats(struct travelMonitor * tm, char * virusName, char * date1, char
 			return;
 		}
 
-		tm_get_country_travelStats(country_info, virusName, date1, date2, &accepted, &rejected);
+		tm_get_country_travelStats(country_info, virusName, day1, day2, &accepted, &rejected);
 		printf("TOTAL REQUESTS %d\n", accepted + rejected);		// print stats
 		printf("ACCEPTED %d\n", accepted);
 		printf("REJECTED %d\n\n", rejected);
 	}
-	else		// no specific country was given, so do the same thing for all countries in database
+	else		// no specific country was given, so count the travel requests to all countries
 	{
-		TM_CountryInfo country_info;
-		// iterate upon the hash-table of countries of travelMonitor
-		while ((country_info = (TM_CountryInfo) hash_iterate_next(tm->countries_info)) != NULL)
-		{
-			int temp_accepted = 0, temp_rejected = 0;
-			tm_get_country_travelStats(country_info, virusName, date1, date2, &temp_accepted, &temp_rejected);
-			rejected += temp_rejected; accepted += temp_accepted;		// sum the accepted and rejected for all countries
-		}
+		tm_travel_stats_get(tm->travel_stats, virusName, day1, day2, &accepted, &rejected);
 
 		printf("TOTAL REQUESTS %d\n", accepted + rejected);  // print total stats
 		printf("ACCEPTED %d\n", accepted);
@@ -432,6 +889,7 @@ void travelStats(struct travelMonitor * tm, char * virusName, char * date1, char
 
 void addVaccinationRecords(struct travelMonitor * tm, char * country, const char * input_dir_name)
 {
+	tm_complete_requests(tm);		// requests made so far are answered with the current records, before the Monitor gets to the new ones
 	// first things first we check if given country is valid - is in travelMonitor's database
 	// search for the country in the HT of countries of travelMonitor
 	TM_CountryInfo country_info = (TM_CountryInfo) hash_search(tm->countries_info, country);
@@ -443,51 +901,22 @@ void addVaccinationRecords(struct travelMonitor * tm, char * country, const char
 
 	int monitor_index = tm_get_country_monitor(country_info);		// get the index of monitor that "watches" the specific countryFrom
 	void * message = create_msg1(input_dir_name, country);										// construct message
-	send_message(tm->monitors_info[monitor_index]->write_fd, MSG1, message, tm->bufferSize);	// send message
-	int msgd_done;
-	read_message(tm->monitors_info[monitor_index]->read_fd, &msgd_done, tm->bufferSize);		// read response message (should be a DONE message)
-	if (msgd_done != DONE)
-	{
-		fprintf(stderr, "[Error] : addVaccinationRecords -> Unexpected message descriptor\n\n");
-		exit(EXIT_FAILURE);						
-	}
+	tm_reactor_send(tm, monitor_index, MSG1, message);		// send message
+	tm_reactor_expect(tm, monitor_index);
+	tm_reactor_wait(tm, done_handler, NULL);		// read response message (should be a DONE message)
 	
 	if( kill(tm->monitors_info[monitor_index]->pid, SIGUSR1) < 0)				// sends a SIGUSR1 to Monitor process
 		perror("[Error] addVaccinationRecords -> kill\n");
 
-	int msgd = -2;
-	while (msgd != DONE)		// now we read all the updated bloom filters sent from Monitor process
-	{
-		void * response_msg = read_message(tm->monitors_info[monitor_index]->read_fd, &msgd, tm->bufferSize);	//read response message
-		if (msgd != DONE)	// if message still has data (Monitor has not sent DONE msgd yet)
-		{
-			char virus[20]; void * bit_array;
-			if (decode_msg2(msgd, response_msg, virus, &bit_array) < 0)		// decode message of expected type (MSG2) 	
-				exit(EXIT_FAILURE);
-			TM_VirusInfo virus_info = hash_search(tm->monitors_info[monitor_index]->viruses_info, virus);		// search for the virus of message into Monitors HT of viruses
-			if (virus_info != NULL)		// if found (virus already exists)
-			{
-				// just update the bloom filter (existing bit array) of virus
-				bloom_bit_array_copy(tm_get_bloom_filter(virus_info), bit_array);
-			}
-			else  // if not found (virus is a new virus)
-			{
-				virus_info = tm_virus_info_create(virus, tm->bloom_size, bit_array);		// create new virus_info 
-				hash_insert(tm->monitors_info[monitor_index]->viruses_info, virus_info);	//update viruses_info HT
-			}
-
-			delete_message(response_msg);  	// message is read and decoded, no longer needed
-		}
-
-	}
+	tm_reactor_expect(tm, monitor_index);
+	tm_reactor_wait(tm, bloom_filter_handler, NULL);		// now we read all the updated bloom filters sent from Monitor process
 
 	printf("travelMonitor -> Bloom filters structures have been updated\n\n");
 }
 
 void searchVaccinationStatus(struct travelMonitor * tm, char * citizenID)
 {
-	int found = 0;
-
+	tm_complete_requests(tm);		// results of earlier travel requests are printed first
 	for (int i = 0; i < strlen(citizenID); i++)	// check for an integer citizenID
 	{
 		if (citizenID[i] < '0' || citizenID[i] > '9')
@@ -506,86 +935,14 @@ void searchVaccinationStatus(struct travelMonitor * tm, char * citizenID)
 	for ( int i = 0; i < tm->numMonitors; ++i)		// travelMonitor sends message to all Monitor child processes
 	{
 		void * message = create_msg5(citizenID);										// construct message
-		send_message(tm->monitors_info[i]->write_fd, MSG5, message, tm->bufferSize);	// send message
+		tm_reactor_send(tm, i, MSG5, message);			// send message
 	}
 
-	int done_monitors = 0;
-	fd_set readfds;
-	
-	int is_set[tm->numMonitors];				// keeps track of which child monitor processes have been dealt with (parent has read all info about citizenID from them)
-	for (int i = 0; i < tm->numMonitors; ++i)
-		is_set[i] = 0;							// initially all read fd are not set
+	struct status_query query = { citizenID, 0 };
+	tm_reactor_expect_all(tm);
+	tm_reactor_wait(tm, vaccination_status_handler, &query);		// repeat until all child monitor processes info has been read by travelMonitor
 
-	while (done_monitors != tm->numMonitors)	// repeat until all child monitor processes info has been read by travelMonitor
-	{
-		FD_ZERO(&readfds);						// reinitialize the set of read fds to wait on
-		int max_fd = 0;
-		
-		for (int i = 0; i < tm->numMonitors; ++i)
-		{
-			if (!is_set[i])
-			{
-				FD_SET(tm->monitors_info[i]->read_fd, &readfds);			// each iteration we set the read fds not yet set
-				if (tm->monitors_info[i]->read_fd > max_fd)
-					max_fd = tm->monitors_info[i]->read_fd;				// find max file descriptor for first arg in select
-			}
-		}
-
-		if (select(max_fd + 1, &readfds, NULL, NULL, NULL) < 0)
-		{
-			perror("[Error] : searchVaccinationStatus -> select\n");
-			exit(EXIT_FAILURE);
-		}
-
-		for (int i = 0; i < tm->numMonitors; ++i)
-		{
-			if (!is_set[i])		// we only care for those read fd not yet set (still pending)
-			{
-				if(FD_ISSET(tm->monitors_info[i]->read_fd, &readfds))		// if readfd was set this time (we can safely read without fear of blocking - there is data in the read end of pipe)
-				{	
-					int msgd;
-					void * message = read_message(tm->monitors_info[i]->read_fd, &msgd, tm->bufferSize);	//read message data and its header-msgd
-					if (msgd != DONE)	// if message still has data (has not sent DONE msgd yet)
-					{
-						if (msgd == MSG6)		// MSG6 means Monitor sent name, surname, country, age about given citizenID
-						{
-							char name[13], surname[13], country[30]; int age;
-							if (decode_msg6(msgd, message, name, surname, country, &age) < 0)
-								exit(EXIT_FAILURE);
-							found = 1;							// at least one monitor process found given citizenID
-							printf("%s %s %s %s\n", citizenID, name, surname, country);
-							printf("AGE %d\n", age);
-						}
-						else if (msgd == MSG7)	// MSG7 means Monitor sent vaccination info about given citizenID (virusname, vaccination status, date)
-						{
-							char virus[20] , status[4], date[12];
-							if (decode_msg7(msgd, message, virus, status, date) < 0)
-								exit(EXIT_FAILURE);
-							printf("%s ", virus);
-							if (!strcmp(status, "YES"))
-								printf("VACCINATED ON %s\n", date);
-							else
-								printf("NOT YET VACCINATED\n");
-						}
-						else		// otherwise we have an IPC error, which should NEVER occur
-						{
-							fprintf(stderr, "[Error] : searchVaccinationStatus -> Unexpected message descriptor\n\n");
-							exit(EXIT_FAILURE);
-						}
-					
-						delete_message(message);  	// message is read and decoded, no longer needed
-					}
-					else	// monitor process sent DONE message, that means it is done sending info about citizenID and is ready for other commands
-					{
-						done_monitors += 1;
-						is_set[i] = 1;			// readfd has finally been set, don't worry about it no more
-					}
-				}
-			}
-		}
-	}
-
-	if (!found)
+	if (!query.found)
 	{
 		printf("[Error] : searchVaccinationStatus -> No Monitor Process found any info about given CitizenID\n");
 		printf("CitizenID : %s does not exist in database\n\n", citizenID);
@@ -596,6 +953,7 @@ void searchVaccinationStatus(struct travelMonitor * tm, char * citizenID)
 
 void exit_travelMonitor(struct travelMonitor * tm)
 {
+	tm_complete_requests(tm);		// all travel requests made must end up in the log file
 	term_monitors(tm);		// terminate child monitor processes
 	wait_monitors(tm);		// call wait() on the children to make sure they all exited
 	tm_log_file_print(tm);		// print info into log file
@@ -646,11 +1004,20 @@ void tm_log_file_print(struct travelMonitor * tm)
 
 	TM_CountryInfo country_info;
 	// iterate upon the hash-table of countries of travelMonitor
-	while ((country_info = (TM_CountryInfo) hash_iterate_next(tm->countries_info)) != NULL)
+	struct hash_cursor cursor;
+	hash_cursor_init(tm->countries_info, &cursor);
+	while ((country_info = (TM_CountryInfo) hash_cursor_next(&cursor)) != NULL)
 		fprintf(file_ptr, "%s\n", tm_get_country_name(country_info));				// print all countries that participated in travelMonitor
 	fprintf(file_ptr, "TOTAL TRAVEL REQUESTS %d\n", tm->accepted + tm->rejected);		// print total travel requests
 	fprintf(file_ptr, "ACCEPTED %d\n", tm->accepted);								// print the #accepted
 	fprintf(file_ptr, "REJECTED %d\n", tm->rejected);								// print the #rejected
+
+	long live[POOL_CLASSES + 1], slabs;
+	pool_stats(live, &slabs);
+	fprintf(file_ptr, "POOL LIVE");															// print the live pool objects of each size class
+	for (int c = 0; c < POOL_CLASSES; ++c)
+		fprintf(file_ptr, " %d:%ld", POOL_MIN_SIZE << c, live[c]);
+	fprintf(file_ptr, " LARGE:%ld SLABS %ld\n", live[POOL_CLASSES], slabs);
 	fclose(file_ptr);
 }
 
@@ -661,6 +1028,7 @@ void travelMonitor_del(struct travelMonitor * tm)
 
 	for (int i = 0; i < tm->numMonitors; ++i)
 	{
+		tm_reactor_remove(tm, i);						/* destroy the connection to the monitor */
 		close(tm->monitors_info[i]->write_fd);		/* close the write/read file descriptors */
 		close(tm->monitors_info[i]->read_fd);
 		/* and now, assuming child has closed his read/write file descriptors, unlink the fifos */
@@ -670,10 +1038,16 @@ void travelMonitor_del(struct travelMonitor * tm)
 		snprintf(fifo_read_path, 30, "fifo%dR", i+1);	// fifo path for read purposes
 		unlink(fifo_write_path);	// unlink the fifos
 		unlink(fifo_read_path);
+		char snapshot_path[40];
+		snprintf(snapshot_path, 40, "%s%s", fifo_write_path, SNAPSHOT_SUFFIX);	// and the snapshot of the monitor (named after the fifo it reads)
+		unlink(snapshot_path);
 		free(tm->monitors_info[i]);
 	}
 	free(tm->monitors_info);
+	close(tm->epoll_fd);
 	hash_destroy(tm->countries_info);
+	hash_destroy(tm->travel_stats);
+	tm_requests_destroy(tm->requests);
 	free(tm);
 }
 
@@ -682,7 +1056,9 @@ int replaceMonitors(struct travelMonitor * tm, const char * input_dir_name)
 {
 	/* NOTE : we assume a child is unexpectedly terminated only when it is not in a middle of an IPC with the parent */
 	/* otherwise chaos may ensue */ /* this assumption was also suggested by Mr.Doulas on Piazza */
-	int status, msgd;
+	/* travel requests in flight are the exception, requests waiting on a terminated Monitor are failed (see tm_requests_fail) */
+	tm_complete_requests(tm);
+	int status;
 	pid_t pid;
 	/* one or more children were killed, so wait on them first */
 	while ((pid = waitpid(-1, &status, WNOHANG)) > 0 )		/* loop until an error occurs or no remaining children have changed state */
@@ -692,6 +1068,7 @@ int replaceMonitors(struct travelMonitor * tm, const char * input_dir_name)
 			if (tm->monitors_info[i]->pid == pid)		// find the index of the Monitor child process that got terminated
 			{	
 				// close the write and read ends of parent fifos, childrens read and write ends have been automatically closed upon termination
+				tm_reactor_remove(tm, i);
 				close(tm->monitors_info[i]->write_fd);
 				close(tm->monitors_info[i]->read_fd);
 
@@ -728,39 +1105,35 @@ int replaceMonitors(struct travelMonitor * tm, const char * input_dir_name)
 						return -1;
 					}
 
-					void * message = create_msg0(tm->bufferSize, tm->bloom_size);		
-					send_message(tm->monitors_info[i]->write_fd, MSG0, message, tm->bufferSize);	// send the bufferSize and the bloom size as the first message
-					int msgd0;
-					read_message(tm->monitors_info[i]->read_fd, &msgd0, tm->bufferSize);		// read response message from Monitor (should be a DONE message)
-					if (msgd0 != DONE)
-					{
-						fprintf(stderr, "[Error] : replaceMonitors -> Unexpected message descriptor\n\n");
-						return -1;						
-					}
+					tm_reactor_add(tm, i);		// create the new connection and register it to the epoll instance
+
+					void * message = create_msg0(tm->bufferSize, tm->bloom_size, tm->options, tm->hashes, tm->threads);		
+					tm_reactor_send(tm, i, MSG0, message);		// send the bufferSize and the bloom size as the first message
+					tm_reactor_expect(tm, i);
+					tm_reactor_wait(tm, done_handler, NULL);		// read response message from Monitor (should be a DONE message)
 
 					// find all countries that the terminated Monitor child process was handling
 					// and assign them to the newly created Monitor child process
 
 					TM_CountryInfo country_info;
 					// iterate upon the hash-table of countries
-					while ((country_info = hash_iterate_next(tm->countries_info)) != NULL)
+					struct hash_cursor cursor;
+					hash_cursor_init(tm->countries_info, &cursor);
+					while ((country_info = hash_cursor_next(&cursor)) != NULL)
 					{
 						if (tm_get_country_monitor(country_info) == i)		// country was being handled by terminated Monitor child process
 						{													// so newly created Monitor should handle it now
 							void * message = create_msg1(input_dir_name, tm_get_country_name(country_info));			// construct message
-							send_message(tm->monitors_info[i]->write_fd, MSG1_NO_REPLY, message, tm->bufferSize);	    // send message
+							tm_reactor_send(tm, i, MSG1_NO_REPLY, message);	    // send message
 						}
 					}
 
 					// after assigning all subdirectories-countries to the new Monitor process
 					//notify it you are DONE sending subdirectories
-    				send_message(tm->monitors_info[i]->write_fd, DONE, NULL, tm->bufferSize);
-					read_message(tm->monitors_info[i]->read_fd, &msgd, tm->bufferSize);			// Monitor process just created, replies with a DONE message
-					if (msgd != DONE)															// implying everything went fine, and is ready for commands
-					{
-						fprintf(stderr, "[Error] : replaceMonitors -> Unexpected message descriptor\n\n");
-						return -1;
-					}
+    				tm_reactor_send(tm, i, DONE, NULL);
+    				tm_reactor_expect(tm, i);
+					tm_reactor_wait(tm, done_handler, NULL);		// Monitor process just created, replies with a DONE message
+																	// implying everything went fine, and is ready for commands
 
 					break;
 				}
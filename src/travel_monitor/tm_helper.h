@@ -5,6 +5,8 @@
 #include <unistd.h>
 #include <dirent.h>
 #include "hash.h"
+#include "connection.h"
+#include "tm_requests.h"
 
 
 struct monitor_info {			// travelMonitor needs to keep some information about the monitor child processes
@@ -12,6 +14,10 @@ struct monitor_info {			// travelMonitor needs to keep some information about th
 	int read_fd;				// a pipe fd where the travelMonitor reads from (the Monitor process writes)
 	int write_fd;				// a pipe fd where the travelMonitor writes into (the Monitor process reads)
 	HT viruses_info;			// a HT with viruses info for a set of countries associated with certain Monitor, namely a virus name and the Bloom Filters 
+	Connection conn;			// the connection over the read/write fds, with the messages queued for the Monitor and the message partially read from it
+	int waiting;				// 1 if the travelMonitor currently waits on a reply from the Monitor, 0 otherwise
+	int in_flight;				// number of replies to requests (messages with a request id) still to come from the Monitor
+	int hung_up;				// 1 if the Monitor closed its end of the pipe (it was terminated) and is not replaced yet, 0 otherwise
 };
 
 struct travelMonitor {
@@ -20,8 +26,16 @@ struct travelMonitor {
 	int numMonitors;						// number of monitors-child processes
 	int bufferSize;							// the buffer size
 	unsigned int bloom_size;				// the bloom size
+	unsigned int options;					// options of the bloom filters, sent to every Monitor (see messages.h)
+	unsigned int hashes;					// number of hash functions of the bloom filters, sent to every Monitor
+	unsigned int threads;					// number of threads every Monitor reads its files with, sent to every Monitor
 	struct monitor_info **monitors_info;	// travelMonitor struct keeps an array of monitor info
+	int epoll_fd;							// epoll instance where the read/write fds of all monitors are registered
+	int waiting_monitors;					// number of monitors the travelMonitor currently waits on
+	int requests_in_flight;					// number of replies to requests still to come from all monitors
+	TM_Requests requests;					// the travel requests whose results have not been printed yet, in the order they were made
 	HT countries_info;						// a HT with country information namely a name of country and a monitor index (indicates which Monitor process "watches" that country)
+	HT travel_stats;						// the travel requests to all countries, by virus (see tm_travel_stats_add), for /travelStats without a country
 };
 
 
@@ -31,7 +45,7 @@ struct travelMonitor {
 /*===================== INITIALIZATION PHASE ===========================*/
 
 // initializes the travelMonitor structure and all its substructures that are needed
-struct travelMonitor * travelMonitor_init(int numMonitors, int bufferSize, unsigned int bloom_size, DIR * input_dir);
+struct travelMonitor * travelMonitor_init(int numMonitors, int bufferSize, unsigned int bloom_size, unsigned int options, unsigned int threads, DIR * input_dir);
 // initializes the ipc (creates the named pipes, forks and execs the child processes, opens the named pipes for the travelMonitor)
 void ipc_init(struct travelMonitor * tm);
 // assigns sub-directories of input_dir to the Monitor processes
@@ -42,7 +56,18 @@ void wait_monitors_bfs(struct travelMonitor * tm);
 
 /* =================== QUERY PHASE ========================= */
 
+// travel requests are pipelined : the query is sent to the Monitor and travelRequest returns without waiting for the answer
+// results are printed in the order of the requests, as soon as all earlier requests have their results too
 void travelRequest(struct travelMonitor * tm, char * citizenID, char * date, char * countryFrom, char * countryTo, char * virusName);
+// makes all the travel requests of given file (one request per line : citizenID date countryFrom countryTo virusName)
+// every Monitor gets asked once, about all the requests of the batch that concern it, and only the total counts are printed
+void travelRequestBatch(struct travelMonitor * tm, char * file_name);
+// called by the reactor for each reply (a message with request id req_id) of a Monitor to a request in flight
+int tm_request_complete(struct travelMonitor * tm, int monitor_index, int msgd, int req_id, void * message);
+// called by the reactor when the Monitor with given index hung up, the travel requests waiting on its answer are failed
+void tm_requests_fail(struct travelMonitor * tm, int monitor_index);
+// waits until all travel requests in flight are completed and their results have been printed
+void tm_complete_requests(struct travelMonitor * tm);
 void travelStats(struct travelMonitor * tm, char * virusName, char * date1, char * date2, char * country);
 void addVaccinationRecords(struct travelMonitor * tm, char * country, const char * input_dir_name);
 void searchVaccinationStatus(struct travelMonitor * tm, char * citizenID);
@@ -3,32 +3,36 @@
 #include <stdlib.h>
 #include <string.h>
 #include "bloom.h"
-#include "list.h"
-#include "date.h"
+#include "xor_filter.h"
+#include "hash.h"
+#include "fenwick.h"
 #include "tm_items.h"
 #include <assert.h>
 
 struct tm_virus_info {
 	char * virus_name;						// name of the virus
-	Bloom bloom_filter;						// bloom filter for virus
+	Bloom bloom_filter;						// bloom filter for virus (NULL if the Monitor sends xor filters instead)
+	XorFilter xor_filter;					// xor filter for virus, that is checked instead of the bloom filter (NULL if not used)
+	pid_t pid;								// if the bloom filter is shared, the Monitor process that owns it
+	int shm_fd;								// and the fd of the shared memory segment in that process (-1 if the bloom filter is a private copy)
 };
 
 
-struct tm_travelRequest {	// a struct that keeps information for a travel Request
-	char * date;			// a date of travel
-	char * virus;			// a virus for whom vaccination is checked
-	int result;				// a result 1 for accepted, 0 for rejected
+struct tm_travel_stats {	// a struct that keeps the travel requests for a virus
+	char * virus_name;		// a virus for whom vaccination is checked
+	Fenwick accepted;		// number of accepted requests, by date of travel (a day number, see date.h)
+	Fenwick rejected;		// number of rejected requests, by date of travel
 };
 
 struct tm_country_info {
 	char * country_name;
 	int monitor_index;			// index/number of monitor that monitors this country
-	List travel_requests;		// a list of travel requests (list of struct tm_travel_info)
+	HT travel_stats;			// the travel requests to this country, by virus (TM_TravelStats)
 };
 
 
 
-TM_VirusInfo tm_virus_info_create(char * virus_name, unsigned int bloom_size, void * bit_array)
+TM_VirusInfo tm_virus_info_create(char * virus_name, unsigned int bloom_size, unsigned int hashes, bool blocked, void * bit_array)
 {
 	TM_VirusInfo info = malloc(sizeof(struct tm_virus_info));
 	if (info == NULL)
@@ -38,10 +42,133 @@ TM_VirusInfo tm_virus_info_create(char * virus_name, unsigned int bloom_size, vo
 	info->virus_name = malloc(strlen(virus_name) + 1);
 	strcpy(info->virus_name, virus_name);
 
-	info->bloom_filter = bloom_copy_create(bloom_size, bit_array);
+	// a bloom filter with all bits zero if no bit array is given (to be overwritten through tm_virus_info_bit_array)
+	info->bloom_filter = (bit_array != NULL) ? bloom_copy_create(bloom_size, hashes, blocked, bit_array) : bloom_create(bloom_size, hashes, blocked);
+	info->xor_filter = NULL;
+	info->pid = -1;
+	info->shm_fd = -1;
 	return info;
 }
 
+// maps the bloom filter that is shared by the Monitor process with given pid, through the fd shm_fd of that process
+static Bloom attach(unsigned int bloom_size, unsigned int hashes, bool blocked, pid_t pid, int shm_fd)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/%d/fd/%d", (int) pid, shm_fd);
+	Bloom bloom = bloom_attach(bloom_size, hashes, blocked, path);
+	if (bloom == NULL)
+		perror("Error : tm_virus_info -> bloom_attach\n");
+	return bloom;
+}
+
+TM_VirusInfo tm_virus_info_create_shared(char * virus_name, unsigned int bloom_size, unsigned int hashes, bool blocked, pid_t pid, int shm_fd)
+{
+	Bloom bloom = attach(bloom_size, hashes, blocked, pid, shm_fd);
+	if (bloom == NULL)
+		return NULL;
+
+	TM_VirusInfo info = malloc(sizeof(struct tm_virus_info));
+	if (info == NULL)
+		fprintf(stderr, "Error : tm_virus_info_create_shared -> malloc\n");
+	assert(info != NULL);
+
+	info->virus_name = malloc(strlen(virus_name) + 1);
+	strcpy(info->virus_name, virus_name);
+
+	info->bloom_filter = bloom;
+	info->xor_filter = NULL;
+	info->pid = pid;
+	info->shm_fd = shm_fd;
+	return info;
+}
+
+TM_VirusInfo tm_virus_info_create_xor(char * virus_name, XorFilter filter)
+{
+	TM_VirusInfo info = malloc(sizeof(struct tm_virus_info));
+	if (info == NULL)
+		fprintf(stderr, "Error : tm_virus_info_create_xor -> malloc\n");
+	assert(info != NULL);
+
+	info->virus_name = malloc(strlen(virus_name) + 1);
+	strcpy(info->virus_name, virus_name);
+
+	info->bloom_filter = NULL;
+	info->xor_filter = filter;
+	info->pid = -1;
+	info->shm_fd = -1;
+	return info;
+}
+
+// drops the filters of virus, before they are replaced by another one
+static void drop_filters(TM_VirusInfo info)
+{
+	if (info->bloom_filter != NULL)
+		bloom_destroy(info->bloom_filter);
+	if (info->xor_filter != NULL)
+		xor_filter_destroy(info->xor_filter);
+	info->bloom_filter = NULL;
+	info->xor_filter = NULL;
+	info->pid = -1;
+	info->shm_fd = -1;
+}
+
+void * tm_virus_info_bit_array(TM_VirusInfo info, unsigned int bloom_size, unsigned int hashes, bool blocked)
+{
+	if (info->bloom_filter == NULL || info->bloom_filter->shared)		// a shared bit array is read only, so it is replaced by a private one
+	{
+		drop_filters(info);
+		info->bloom_filter = bloom_create(bloom_size, hashes, blocked);
+	}
+	return info->bloom_filter->bit_array;
+}
+
+int tm_virus_info_update_words(TM_VirusInfo info, unsigned int first_word, unsigned int count, void * words)
+{
+	if (info->bloom_filter == NULL || info->bloom_filter->shared || first_word + count > bloom_num_words(info->bloom_filter))	// only a private copy can be updated in place
+		return -1;
+	bloom_set_words(info->bloom_filter, first_word, count, words);
+	return 0;
+}
+
+int tm_virus_info_update_shared(TM_VirusInfo info, unsigned int bloom_size, unsigned int hashes, bool blocked, pid_t pid, int shm_fd)
+{
+	if (info->pid == pid && info->shm_fd == shm_fd)		// already mapped, every update of the Monitor is visible right away
+		return 0;
+
+	Bloom bloom = attach(bloom_size, hashes, blocked, pid, shm_fd);		// bloom filter is now shared by another Monitor (or was a private copy)
+	if (bloom == NULL)
+		return -1;
+	drop_filters(info);
+	info->bloom_filter = bloom;
+	info->pid = pid;
+	info->shm_fd = shm_fd;
+	return 0;
+}
+
+void tm_virus_info_update_xor(TM_VirusInfo info, XorFilter filter)
+{
+	drop_filters(info);		// a xor filter is immutable, each update of the Monitor is a whole new one
+	info->xor_filter = filter;
+}
+
+bool tm_virus_info_check(TM_VirusInfo info, unsigned char * citizenID)
+{
+	if (info->xor_filter != NULL)
+		return xor_filter_check(info->xor_filter, citizenID);
+	return bloom_check(info->bloom_filter, citizenID);
+}
+
+void tm_virus_info_check_many(TM_VirusInfo info, unsigned char ** citizenIDs, unsigned int n, bool * maybe)
+{
+	if (info->xor_filter == NULL)
+	{
+		bloom_check_many(info->bloom_filter, citizenIDs, n, maybe);
+		return;
+	}
+	for (unsigned int i = 0; i < n; i++)		// three accesses per lookup, there is not much to overlap
+		maybe[i] = xor_filter_check(info->xor_filter, citizenIDs[i]);
+}
+
 void tm_virus_info_destroy(TM_VirusInfo info)
 {
 	if (info == NULL)
@@ -49,8 +176,8 @@ void tm_virus_info_destroy(TM_VirusInfo info)
 	assert(info != NULL);
 
 	free(info->virus_name);
-	bloom_destroy(info->bloom_filter);
-	
+	drop_filters(info);
+
 	free(info);
 }
 
@@ -83,7 +210,7 @@ TM_CountryInfo tm_country_info_create(char * country_name, int monitor_index)
 	info->country_name = malloc(strlen(country_name) + 1);
 	strcpy(info->country_name, country_name);
 	info->monitor_index = monitor_index;
-	info->travel_requests = list_create(6);
+	info->travel_stats = hash_create(8, (HashKey) tm_get_travel_stats_virus, (HashDestroy) tm_travel_stats_destroy);
 
 	return info;
 }
@@ -95,7 +222,7 @@ void tm_country_info_destroy(TM_CountryInfo info)
 	assert(info != NULL);
 
 	free(info->country_name);
-	list_destroy(info->travel_requests);
+	hash_destroy(info->travel_stats);
 	free(info);
 }
 
@@ -114,75 +241,72 @@ void tm_country_info_print(TM_CountryInfo info)
 	printf("Country %s,  monitor %d\n", info->country_name, info->monitor_index);
 }
 
-void tm_country_add_travelRequest(TM_CountryInfo info, char * date, char * virus, int result)
+void tm_country_add_travelRequest(TM_CountryInfo info, unsigned int date, char * virus, int result)
 {
 	if (info == NULL)
 		fprintf(stderr, "Error : tm_country_add_travelRequest -> info is NULL\n");
 	assert(info != NULL);
 
-	TM_TravelRequest request = tm_travelRequest_create(date, virus, result);
-	list_insert_end(info->travel_requests, request);
+	tm_travel_stats_add(info->travel_stats, date, virus, result);
 }
 
-void tm_get_country_travelStats(TM_CountryInfo info, char * virusName, char * date1, char * date2, int * accepted, int * rejected)
+void tm_get_country_travelStats(TM_CountryInfo info, char * virusName, unsigned int date1, unsigned int date2, int * accepted, int * rejected)
 {
-	*accepted = 0; *rejected = 0;
-	for (ListNode node = list_first(info->travel_requests); node != NULL; node = list_next(info->travel_requests, node)) // iterate list of travelRequests for country
-	{
-		if (!strcmp(((TM_TravelRequest) list_value(info->travel_requests, node))->virus, virusName))		// if virus of travel request is the one checked
-		{
-			if (date_cmp(date1, ((TM_TravelRequest) list_value(info->travel_requests, node))->date) <= 0 && 
-				date_cmp(((TM_TravelRequest) list_value(info->travel_requests, node))->date, date2) <= 0) // and if the date of request is within the given interval
-			{
-				if (((TM_TravelRequest) list_value(info->travel_requests, node))->result)	// update the accepted and rejected counters
-					*accepted += 1;		
-				else
-					*rejected += 1;
-			}
-		}
-	}
+	tm_travel_stats_get(info->travel_stats, virusName, date1, date2, accepted, rejected);
 }
 
 /*_______________________________________________________________*/
 
-TM_TravelRequest tm_travelRequest_create(char * date, char * virus, int result)
+TM_TravelStats tm_travel_stats_create(char * virus_name)
 {
-	TM_TravelRequest request = malloc(sizeof(struct tm_travelRequest));
-	if (request == NULL)
-		fprintf(stderr, "Error : tm_travelRequest_create -> malloc\n");
-	assert(request != NULL);
+	TM_TravelStats stats = malloc(sizeof(struct tm_travel_stats));
+	if (stats == NULL)
+		fprintf(stderr, "Error : tm_travel_stats_create -> malloc\n");
+	assert(stats != NULL);
 
-	request->date = malloc(strlen(date) + 1);
-	strcpy(request->date, date);
-	request->virus = malloc(strlen(virus) + 1);
-	strcpy(request->virus, virus);
-	request->result = result;
+	stats->virus_name = malloc(strlen(virus_name) + 1);
+	strcpy(stats->virus_name, virus_name);
+	stats->accepted = fenwick_create();
+	stats->rejected = fenwick_create();
 
-	return request;
+	return stats;
 }
 
-void tm_travelRequest_destroy(TM_TravelRequest request)
+void tm_travel_stats_destroy(TM_TravelStats stats)
 {
-	if (request == NULL)
-		fprintf(stderr, "Error : tm_travelRequest_destroy -> request is NULL\n");
-	assert(request != NULL);
-
-	free(request->date);
-	free(request->virus);
-	free(request);
+	if (stats == NULL)
+		fprintf(stderr, "Error : tm_travel_stats_destroy -> stats is NULL\n");
+	assert(stats != NULL);
+
+	free(stats->virus_name);
+	fenwick_destroy(stats->accepted);
+	fenwick_destroy(stats->rejected);
+	free(stats);
 }
 
-char * tm_get_travelRequest_date(TM_TravelRequest request)
+char * tm_get_travel_stats_virus(TM_TravelStats stats)
 {
-	return request->date;
+	return stats->virus_name;
 }
 
-char * tm_get_travelRequest_virus(TM_TravelRequest request)
+void tm_travel_stats_add(HT stats, unsigned int date, char * virus, int result)
 {
-	return request->virus;
+	TM_TravelStats virus_stats = (TM_TravelStats) hash_search(stats, virus);
+	if (virus_stats == NULL)		// first travel request for this virus
+	{
+		virus_stats = tm_travel_stats_create(virus);
+		hash_insert(stats, virus_stats);
+	}
+	fenwick_add(result ? virus_stats->accepted : virus_stats->rejected, date, 1);
 }
 
-int tm_get_travelRequest_result(TM_TravelRequest request)
+void tm_travel_stats_get(HT stats, char * virus, unsigned int date1, unsigned int date2, int * accepted, int * rejected)
 {
-	return request->result;
-}
\ No newline at end of file
+	*accepted = 0; *rejected = 0;
+	TM_TravelStats virus_stats = (TM_TravelStats) hash_search(stats, virus);
+	if (virus_stats != NULL)		// otherwise there were no travel requests for this virus
+	{
+		*accepted = fenwick_range(virus_stats->accepted, date1, date2);
+		*rejected = fenwick_range(virus_stats->rejected, date1, date2);
+	}
+}
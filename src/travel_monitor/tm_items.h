@@ -1,12 +1,24 @@
 /* file : tm_items.h (travel monitor items) */
 #pragma once
+#include <sys/types.h>
+#include <stdbool.h>
 #include "bloom.h"
+#include "xor_filter.h"
+#include "hash.h"
 
 typedef struct tm_virus_info * TM_VirusInfo;
 typedef struct tm_country_info * TM_CountryInfo;
-typedef struct tm_travelRequest * TM_TravelRequest;
+typedef struct tm_travel_stats * TM_TravelStats;
 
-TM_VirusInfo tm_virus_info_create(char * virus_name, unsigned int bloom_size, void * bit_array);
+TM_VirusInfo tm_virus_info_create(char * virus_name, unsigned int bloom_size, unsigned int hashes, bool blocked, void * bit_array);
+TM_VirusInfo tm_virus_info_create_shared(char * virus_name, unsigned int bloom_size, unsigned int hashes, bool blocked, pid_t pid, int shm_fd);
+TM_VirusInfo tm_virus_info_create_xor(char * virus_name, XorFilter filter);
+void * tm_virus_info_bit_array(TM_VirusInfo info, unsigned int bloom_size, unsigned int hashes, bool blocked);
+int tm_virus_info_update_words(TM_VirusInfo info, unsigned int first_word, unsigned int count, void * words);
+int tm_virus_info_update_shared(TM_VirusInfo info, unsigned int bloom_size, unsigned int hashes, bool blocked, pid_t pid, int shm_fd);
+void tm_virus_info_update_xor(TM_VirusInfo info, XorFilter filter);
+bool tm_virus_info_check(TM_VirusInfo info, unsigned char * citizenID);
+void tm_virus_info_check_many(TM_VirusInfo info, unsigned char ** citizenIDs, unsigned int n, bool * maybe);
 void tm_virus_info_destroy(TM_VirusInfo info);
 char * tm_get_virus_name(TM_VirusInfo info);
 Bloom tm_get_bloom_filter(TM_VirusInfo info);
@@ -19,13 +31,16 @@ void tm_country_info_destroy(TM_CountryInfo info);
 char * tm_get_country_name(TM_CountryInfo info);
 int tm_get_country_monitor(TM_CountryInfo info);
 void tm_country_info_print(TM_CountryInfo info);
-void tm_country_add_travelRequest(TM_CountryInfo info, char * date, char * virus, int result);
-void tm_get_country_travelStats(TM_CountryInfo info, char * virusName, char * date1, char * date2, int * accepted, int * rejected);
+void tm_country_add_travelRequest(TM_CountryInfo info, unsigned int date, char * virus, int result);
+void tm_get_country_travelStats(TM_CountryInfo info, char * virusName, unsigned int date1, unsigned int date2, int * accepted, int * rejected);
 
 /*_____________________________________________________________________________________________________*/
 
-TM_TravelRequest tm_travelRequest_create(char * date, char * virus, int result);
-void tm_travelRequest_destroy(TM_TravelRequest request);
-char * tm_get_travelRequest_date(TM_TravelRequest request);
-char * tm_get_travelRequest_virus(TM_TravelRequest request);
-int tm_get_travelRequest_result(TM_TravelRequest request);
\ No newline at end of file
+// the travel requests for a virus, accepted and rejected, counted by date
+TM_TravelStats tm_travel_stats_create(char * virus_name);
+void tm_travel_stats_destroy(TM_TravelStats stats);
+char * tm_get_travel_stats_virus(TM_TravelStats stats);
+// adds a travel request on given date for given virus, with given result (1 for accepted, 0 for rejected), to stats (a HT of TM_TravelStats)
+void tm_travel_stats_add(HT stats, unsigned int date, char * virus, int result);
+// returns the number of accepted and rejected travel requests of stats for given virus, with dates from date1 up to date2
+void tm_travel_stats_get(HT stats, char * virus, unsigned int date1, unsigned int date2, int * accepted, int * rejected);
\ No newline at end of file
@@ -0,0 +1,268 @@
+/* file : tm_reactor.c */
+/* the epoll event loop of the travelMonitor is developed here */
+/* every read fd of a Monitor process is registered once, with the index of the Monitor as its data, so that */
+/* each wakeup costs O(ready fds) instead of rebuilding and rescanning an fd_set of all Monitors, and there is no FD_SETSIZE limit */
+/* write fds are registered as well, but they are only armed (EPOLLOUT) while their connection has queued messages */
+/* replies carrying a request id (!= 0) belong to requests in flight and are passed to tm_request_complete, whenever they arrive */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "tm_helper.h"
+#include "tm_reactor.h"
+#include "tm_requests.h"
+#include "connection.h"
+#include "messages.h"
+
+#define REACTOR_MAX_EVENTS 64			// max number of ready fds returned by a single epoll_wait
+#define REACTOR_WRITE_EVENT 0x80000000	// set in the event data of write fds, to tell them apart from read fds
+
+
+// sets the events of interest of the write fd of given Monitor (0 or EPOLLOUT)
+static void arm_write_fd(struct travelMonitor * tm, int monitor_index, unsigned int events)
+{
+	struct epoll_event event;
+	event.events = events;
+	event.data.u32 = monitor_index | REACTOR_WRITE_EVENT;
+
+	if (epoll_ctl(tm->epoll_fd, EPOLL_CTL_MOD, tm->monitors_info[monitor_index]->write_fd, &event) < 0)
+	{
+		perror("[Error] : arm_write_fd -> epoll_ctl\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+int tm_reactor_create(void)
+{
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);		// close on exec, the Monitor child processes have no use for it
+	if (epoll_fd < 0)
+	{
+		perror("[Error] : tm_reactor_create -> epoll_create1\n");
+		exit(EXIT_FAILURE);
+	}
+	return epoll_fd;
+}
+
+void tm_reactor_add(struct travelMonitor * tm, int monitor_index)
+{
+	struct monitor_info * info = tm->monitors_info[monitor_index];
+	info->conn = conn_create(info->read_fd, info->write_fd, tm->bufferSize);
+	info->waiting = 0;
+	info->in_flight = 0;
+	info->hung_up = 0;
+
+	struct epoll_event event;
+	event.events = EPOLLIN;						// level triggered, we are notified as long as there is data in the read end of the pipe
+	event.data.u32 = monitor_index;				// so that we know right away which Monitor each ready fd belongs to
+
+	if (epoll_ctl(tm->epoll_fd, EPOLL_CTL_ADD, info->read_fd, &event) < 0)
+	{
+		perror("[Error] : tm_reactor_add -> epoll_ctl\n");
+		exit(EXIT_FAILURE);
+	}
+
+	event.events = 0;							// nothing to write yet
+	event.data.u32 = monitor_index | REACTOR_WRITE_EVENT;
+	if (epoll_ctl(tm->epoll_fd, EPOLL_CTL_ADD, info->write_fd, &event) < 0)
+	{
+		perror("[Error] : tm_reactor_add -> epoll_ctl\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+void tm_reactor_remove(struct travelMonitor * tm, int monitor_index)
+{
+	struct monitor_info * info = tm->monitors_info[monitor_index];
+	if (epoll_ctl(tm->epoll_fd, EPOLL_CTL_DEL, info->read_fd, NULL) < 0 && errno != ENOENT)		// read fd is already removed if the Monitor hung up
+		perror("[Error] : tm_reactor_remove -> epoll_ctl\n");
+	if (epoll_ctl(tm->epoll_fd, EPOLL_CTL_DEL, info->write_fd, NULL) < 0)
+		perror("[Error] : tm_reactor_remove -> epoll_ctl\n");
+
+	if (info->waiting)			// the Monitor will never reply
+	{
+		info->waiting = 0;
+		tm->waiting_monitors -= 1;
+	}
+	tm->requests_in_flight -= info->in_flight;		// nor answer any requests
+	info->in_flight = 0;
+	conn_destroy(info->conn);
+	info->conn = NULL;
+}
+
+// queues a message with given request id and writes as much of it as possible
+static void send_message_conn(struct travelMonitor * tm, int monitor_index, int msgd, int req_id, void * message)
+{
+	Connection conn = tm->monitors_info[monitor_index]->conn;
+	int was_pending = conn_has_pending_writes(conn);
+
+	conn_send(conn, msgd, req_id, message);		// queue the message
+	if (!was_pending && !conn_flush(conn))		// and if it did not fit in the pipe as a whole, get notified when there is room for the rest
+		arm_write_fd(tm, monitor_index, EPOLLOUT);
+}
+
+void tm_reactor_send(struct travelMonitor * tm, int monitor_index, int msgd, void * message)
+{
+	send_message_conn(tm, monitor_index, msgd, 0, message);
+}
+
+int tm_reactor_send_request(struct travelMonitor * tm, int monitor_index, int msgd, int req_id, void * message)
+{
+	if (tm->monitors_info[monitor_index]->hung_up)		// the Monitor would never answer
+	{
+		delete_message(message);
+		return -1;
+	}
+	send_message_conn(tm, monitor_index, msgd, req_id, message);
+	tm->monitors_info[monitor_index]->in_flight += 1;		// one more reply to come from the Monitor
+	tm->requests_in_flight += 1;
+	return 0;
+}
+
+void tm_reactor_expect(struct travelMonitor * tm, int monitor_index)
+{
+	if (tm->monitors_info[monitor_index]->hung_up)		// its read fd is no longer watched, it can not be waited on
+	{
+		fprintf(stderr, "[Error] : tm_reactor_expect -> Monitor %d hung up, it will not be waited on\n\n", monitor_index);
+		return;
+	}
+	if (!tm->monitors_info[monitor_index]->waiting)
+	{
+		tm->monitors_info[monitor_index]->waiting = 1;
+		tm->waiting_monitors += 1;
+	}
+}
+
+void tm_reactor_expect_all(struct travelMonitor * tm)
+{
+	for (int i = 0; i < tm->numMonitors; ++i)
+		tm_reactor_expect(tm, i);
+}
+
+// the Monitor with given index hung up (its write end was closed and there is nothing left to read), it will not reply anymore
+static void hung_up(struct travelMonitor * tm, int monitor_index)
+{
+	struct monitor_info * info = tm->monitors_info[monitor_index];
+	fprintf(stderr, "[Error] : tm_reactor -> Monitor %d hung up, it will not be waited on\n\n", monitor_index);
+
+	// stop watching its read fd, otherwise epoll keeps reporting the hang up until the Monitor gets replaced
+	if (epoll_ctl(tm->epoll_fd, EPOLL_CTL_DEL, info->read_fd, NULL) < 0)
+		perror("[Error] : tm_reactor -> epoll_ctl\n");
+	info->hung_up = 1;
+
+	if (info->waiting)
+	{
+		info->waiting = 0;
+		tm->waiting_monitors -= 1;
+	}
+	if (info->in_flight)		// requests sent to the Monitor will never be answered
+	{
+		tm->requests_in_flight -= info->in_flight;
+		info->in_flight = 0;
+		tm_requests_fail(tm, monitor_index);
+	}
+}
+
+// reads all the complete messages available from the Monitor with given index and dispatches them
+// replies to requests go to tm_request_complete, the rest to the handler
+static void handle_read(struct travelMonitor * tm, int monitor_index, tm_msg_handler handler, void * arg)
+{
+	struct monitor_info * info = tm->monitors_info[monitor_index];
+
+	while (info->waiting || info->in_flight)		// after a Monitor is done, anything else it sends belongs to the next round
+	{
+		int msgd, req_id;
+		void * message;
+		int status = conn_read(info->conn, &msgd, &req_id, &message);	// read message data and its header-msgd/request id
+		if (status == CONN_MSG_PARTIAL)		// rest of the message has not arrived yet, we will be notified when it does
+			return;
+		if (status == CONN_EOF)				// the write end was closed and there is nothing left to read (Monitor was terminated)
+		{
+			hung_up(tm, monitor_index);
+			return;
+		}
+
+		if (req_id != 0)		// reply to a request in flight
+		{
+			if (!info->in_flight)
+			{
+				fprintf(stderr, "[Error] : tm_reactor -> Unexpected reply from Monitor %d\n\n", monitor_index);
+				exit(EXIT_FAILURE);
+			}
+			info->in_flight -= 1;
+			tm->requests_in_flight -= 1;
+			if (tm_request_complete(tm, monitor_index, msgd, req_id, message) < 0)
+				exit(EXIT_FAILURE);
+			continue;
+		}
+
+		if (!info->waiting || handler == NULL)		// a message that nobody waits on, an IPC error which should NEVER occur
+		{
+			fprintf(stderr, "[Error] : tm_reactor -> Unexpected message from Monitor %d\n\n", monitor_index);
+			exit(EXIT_FAILURE);
+		}
+		status = handler(tm, monitor_index, msgd, message, arg);
+		if (status < 0)
+			exit(EXIT_FAILURE);
+		if (status == 1)		// Monitor is done for this round, don't worry about it no more
+		{
+			info->waiting = 0;
+			tm->waiting_monitors -= 1;
+		}
+	}
+}
+
+// a single round of the event loop, waits at most timeout ms (-1 for no limit) for fds to become ready and serves them
+// returns the number of ready fds
+static int reactor_round(struct travelMonitor * tm, int timeout, tm_msg_handler handler, void * arg)
+{
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+
+	int ready = epoll_wait(tm->epoll_fd, events, REACTOR_MAX_EVENTS, timeout);
+	if (ready < 0)
+	{
+		if (errno == EINTR)		// interrupted by a signal, the caller will just wait again
+			return 0;
+		perror("[Error] : tm_reactor -> epoll_wait\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (int e = 0; e < ready; ++e)		// only the fds that are actually ready are visited
+	{
+		int i = events[e].data.u32 & ~REACTOR_WRITE_EVENT;
+		if (events[e].data.u32 & REACTOR_WRITE_EVENT)		// there is room in the pipe for more of the queued messages
+		{
+			if (conn_flush(tm->monitors_info[i]->conn))		// write queue got empty, stop watching the write fd
+				arm_write_fd(tm, i, 0);
+			continue;
+		}
+
+		struct monitor_info * info = tm->monitors_info[i];
+		if (!info->waiting && !info->in_flight)		// a Monitor we expect nothing from has nothing to say, unless it hung up
+		{
+			int msgd, req_id;
+			void * message;
+			if (conn_read(info->conn, &msgd, &req_id, &message) == CONN_EOF)
+			{
+				hung_up(tm, i);
+				continue;
+			}
+			fprintf(stderr, "[Error] : tm_reactor -> Unexpected message from Monitor %d\n\n", i);	// otherwise we have an IPC error, which should NEVER occur
+			exit(EXIT_FAILURE);
+		}
+		handle_read(tm, i, handler, arg);
+	}
+	return ready;
+}
+
+void tm_reactor_wait(struct travelMonitor * tm, tm_msg_handler handler, void * arg)
+{
+	while (tm->waiting_monitors != 0)		// repeat until all expected Monitors are done
+		reactor_round(tm, -1, handler, arg);
+}
+
+void tm_reactor_poll(struct travelMonitor * tm, int timeout)
+{
+	reactor_round(tm, timeout, NULL, NULL);
+}
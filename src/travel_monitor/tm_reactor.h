@@ -0,0 +1,30 @@
+/* file : tm_reactor.h */
+/* a single epoll based event loop, that owns the connections (pipes) to all Monitor child processes */
+/* all the reads and writes of the travelMonitor from/to the Monitors go through here, and never block on a single Monitor */
+#pragma once
+#include "tm_helper.h"
+
+/* handler that is called for every message the travelMonitor reads from a Monitor process */
+/* returns 1 if the Monitor is done for the current round (i.e. it sent DONE), 0 if more messages are expected from it, -1 if an error occured */
+typedef int (*tm_msg_handler)(struct travelMonitor * tm, int monitor_index, int msgd, void * message, void * arg);
+
+// creates the epoll instance of the travelMonitor
+int tm_reactor_create(void);
+// creates the connection to the Monitor with given index (from its read/write fds) and registers it to the epoll instance
+void tm_reactor_add(struct travelMonitor * tm, int monitor_index);
+// unregisters the Monitor with given index from the epoll instance and destroys its connection (must be called before the fds get closed)
+void tm_reactor_remove(struct travelMonitor * tm, int monitor_index);
+// queues a message for the Monitor with given index, and writes as much of it as possible right away, the rest is written by tm_reactor_wait
+void tm_reactor_send(struct travelMonitor * tm, int monitor_index, int msgd, void * message);
+// like tm_reactor_send, for a request with given request id (!= 0), whose reply is passed to tm_request_complete whenever it arrives
+// returns -1 (and the message is deleted) if the Monitor has hung up, 0 otherwise
+int tm_reactor_send_request(struct travelMonitor * tm, int monitor_index, int msgd, int req_id, void * message);
+// marks the Monitor with given index as one the next tm_reactor_wait should wait on
+void tm_reactor_expect(struct travelMonitor * tm, int monitor_index);
+// marks all Monitors as ones the next tm_reactor_wait should wait on
+void tm_reactor_expect_all(struct travelMonitor * tm);
+// waits on all expected Monitors and dispatches every message read to the handler, until every one of them is done
+// while waiting, any queued messages are written to the Monitors as soon as their pipes have room
+void tm_reactor_wait(struct travelMonitor * tm, tm_msg_handler handler, void * arg);
+// a single round of the event loop, that waits at most timeout ms (0 to not block, -1 for no limit) for replies to requests in flight
+void tm_reactor_poll(struct travelMonitor * tm, int timeout);
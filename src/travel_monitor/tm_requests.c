@@ -0,0 +1,122 @@
+/* file : tm_requests.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include "tm_requests.h"
+
+// data struct for the requests in flight, a ring buffer that grows when it gets full
+struct tm_requests {
+	struct tm_request * ring;		// the requests, oldest first starting from index head
+	int capacity;					// size of the ring
+	int head;						// index of the oldest request
+	int count;						// number of requests in the ring
+	int head_id;					// request id of the oldest request (the rest follow in order)
+	int next_id;					// request id of the next request to be added
+};
+
+// request ids are positive, 0 is kept for messages that are not about a travel request
+static int next_request_id(int req_id)
+{
+	return (req_id == INT_MAX) ? 1 : req_id + 1;
+}
+
+TM_Requests tm_requests_create(void)
+{
+	TM_Requests requests = malloc(sizeof(struct tm_requests));
+	if (requests == NULL)
+		fprintf(stderr, "Error : tm_requests_create -> malloc\n");
+	assert(requests != NULL);
+
+	requests->capacity = 64;
+	requests->ring = malloc(requests->capacity * sizeof(struct tm_request));
+	if (requests->ring == NULL)
+		fprintf(stderr, "Error : tm_requests_create -> malloc\n");
+	assert(requests->ring != NULL);
+
+	requests->head = 0;
+	requests->count = 0;
+	requests->head_id = 1;
+	requests->next_id = 1;
+	return requests;
+}
+
+void tm_requests_destroy(TM_Requests requests)
+{
+	if (requests == NULL)
+		fprintf(stderr, "Error : tm_requests_destroy -> requests is NULL\n");
+	assert(requests != NULL);
+
+	free(requests->ring);
+	free(requests);
+}
+
+// doubles the capacity of the ring, the requests are moved so that the oldest is at index 0
+static void grow(TM_Requests requests)
+{
+	struct tm_request * ring = malloc(2 * requests->capacity * sizeof(struct tm_request));
+	if (ring == NULL)
+		fprintf(stderr, "Error : tm_requests grow -> malloc\n");
+	assert(ring != NULL);
+
+	for (int i = 0; i < requests->count; ++i)
+		ring[i] = requests->ring[(requests->head + i) % requests->capacity];
+
+	free(requests->ring);
+	requests->ring = ring;
+	requests->capacity *= 2;
+	requests->head = 0;
+}
+
+struct tm_request * tm_requests_add(TM_Requests requests)
+{
+	if (requests->count == requests->capacity)
+		grow(requests);
+
+	if (requests->count == 0)		// the new request is the oldest one
+		requests->head_id = requests->next_id;
+
+	struct tm_request * request = &requests->ring[(requests->head + requests->count) % requests->capacity];
+	request->req_id = requests->next_id;
+	request->verdict = REQUEST_PENDING;
+	requests->next_id = next_request_id(requests->next_id);
+	requests->count++;
+	return request;
+}
+
+struct tm_request * tm_requests_get(TM_Requests requests, int req_id)
+{
+	// position of the request relative to the oldest one, request ids wrap around from INT_MAX to 1
+	long long offset = (long long) req_id - requests->head_id;
+	if (offset < 0)
+		offset += INT_MAX;
+	if (req_id <= 0 || offset >= requests->count)		// not in flight
+		return NULL;
+
+	return &requests->ring[(requests->head + offset) % requests->capacity];
+}
+
+struct tm_request * tm_requests_oldest(TM_Requests requests)
+{
+	return tm_requests_at(requests, 0);
+}
+
+struct tm_request * tm_requests_at(TM_Requests requests, int i)
+{
+	if (i < 0 || i >= requests->count)
+		return NULL;
+	return &requests->ring[(requests->head + i) % requests->capacity];
+}
+
+void tm_requests_remove_oldest(TM_Requests requests)
+{
+	assert(requests->count > 0);
+	requests->head = (requests->head + 1) % requests->capacity;
+	requests->head_id = next_request_id(requests->head_id);
+	requests->count--;
+}
+
+int tm_requests_count(TM_Requests requests)
+{
+	return requests->count;
+}
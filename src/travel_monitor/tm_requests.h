@@ -0,0 +1,42 @@
+/* file : tm_requests.h */
+/* the travel requests of the travelMonitor that are in flight, i.e. their results have not been printed yet */
+/* requests are kept in the order they were made, and get request ids in that same order, so that a request is */
+/* found in O(1) from the request id carried in the reply of a Monitor, and results are printed in the order of the requests */
+#pragma once
+#include "tm_items.h"
+
+/* verdicts of a travel request */
+#define REQUEST_PENDING -1					// the Monitor has not answered yet
+#define REQUEST_NOT_VACCINATED 0			// rejected, citizen is not vaccinated
+#define REQUEST_NEEDS_VACCINATION 1			// rejected, vaccination is older than 6 months before the travel date
+#define REQUEST_VACCINATED_AFTER 2			// rejected, vaccination is after the travel date
+#define REQUEST_ACCEPTED 3					// accepted
+#define REQUEST_FAILED 4					// the Monitor asked hung up before it answered
+
+struct tm_request {
+	int req_id;						// request id, carried in the messages to/from the Monitors about this request
+	int verdict;					// one of the verdicts above
+	unsigned int date;				// the date of travel (a day number, see date.h)
+	char virus[21];					// the virus checked (virus names have at most 20 chars, see messages.c)
+	TM_CountryInfo countryTo;		// the country of destination
+	int monitor;					// index of the Monitor asked (the one of countryFrom)
+};
+
+typedef struct tm_requests * TM_Requests;
+
+/* creates an empty set of requests */
+TM_Requests tm_requests_create(void);
+/* destroys the set of requests */
+void tm_requests_destroy(TM_Requests requests);
+/* adds a new pending request with the next request id, and returns it */
+struct tm_request * tm_requests_add(TM_Requests requests);
+/* returns the request with given request id, or NULL if it is not in flight */
+struct tm_request * tm_requests_get(TM_Requests requests, int req_id);
+/* returns the oldest request in flight, or NULL if there is none */
+struct tm_request * tm_requests_oldest(TM_Requests requests);
+/* returns the i-th oldest request in flight (0 is the oldest), or NULL if there are not that many */
+struct tm_request * tm_requests_at(TM_Requests requests, int i);
+/* removes the oldest request in flight */
+void tm_requests_remove_oldest(TM_Requests requests);
+/* returns the number of requests in flight */
+int tm_requests_count(TM_Requests requests);
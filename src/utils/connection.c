@@ -0,0 +1,194 @@
+/* file : connection.c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+#include "connection.h"
+#include "messages.h"
+#include "pool.h"
+
+struct conn_frame {				// a message queued for writing
+	struct message_header header;	// the message descriptor and request id
+	void * body;				// the body of the message (NULL if there is no body)
+	size_t size;				// total size of the frame in bytes (header + body)
+	size_t written;				// bytes of the frame written so far
+	struct conn_frame * next;	// next queued message
+};
+
+#define READ_HEADER 0		// states of the read state machine
+#define READ_BODY 1
+
+struct connection {
+	int read_fd;
+	int write_fd;
+	int bufferSize;					// chunks of at most bufferSize bytes are read/written each time
+	struct conn_frame * first;		// write queue, messages are written in FIFO order
+	struct conn_frame * last;
+	int state;						// READ_HEADER or READ_BODY
+	struct message_header header;	// header of the message being read
+	void * body;					// body of the message being read
+	size_t expected;				// bytes expected for the current state
+	size_t got;						// bytes read so far for the current state
+};
+
+
+Connection conn_create(int read_fd, int write_fd, int bufferSize)
+{
+	Connection conn = malloc(sizeof(struct connection));
+	if (conn == NULL)
+		fprintf(stderr, "Error : conn_create -> malloc\n");
+	assert(conn != NULL);
+
+	conn->read_fd = read_fd;
+	conn->write_fd = write_fd;
+	conn->bufferSize = bufferSize;
+	conn->first = NULL;
+	conn->last = NULL;
+	conn->state = READ_HEADER;		// the first thing to read is a header
+	conn->body = NULL;
+	conn->expected = sizeof(conn->header);
+	conn->got = 0;
+	return conn;
+}
+
+void conn_destroy(Connection conn)
+{
+	if (conn == NULL)
+		fprintf(stderr, "Error : conn_destroy -> conn is NULL\n");
+	assert(conn != NULL);
+
+	struct conn_frame * frame = conn->first;
+	while (frame != NULL)		// discard all messages not yet written
+	{
+		struct conn_frame * next = frame->next;
+		pool_free(frame->body);
+		pool_free(frame);
+		frame = next;
+	}
+	pool_free(conn->body);		// and any message partially read
+	free(conn);
+}
+
+void conn_send(Connection conn, int msgd, int req_id, void * message)
+{
+	struct conn_frame * frame = pool_alloc(sizeof(struct conn_frame));
+
+	frame->header.msgd = msgd;
+	frame->header.req_id = req_id;
+	frame->header.body_size = message_body_size(msgd, message);
+	frame->body = message;
+	frame->size = sizeof(frame->header) + frame->header.body_size;
+	frame->written = 0;
+	frame->next = NULL;
+
+	if (conn->last == NULL)		// append frame at the end of the write queue
+		conn->first = frame;
+	else
+		conn->last->next = frame;
+	conn->last = frame;
+}
+
+int conn_flush(Connection conn)
+{
+	while (conn->first != NULL)		// while there are queued messages
+	{
+		struct conn_frame * frame = conn->first;
+		size_t header_size = sizeof(frame->header);
+		void * data;				// where the next chunk starts
+		size_t pending;				// bytes pending in the current part (header or body) of the frame
+
+		if (frame->written < header_size)		// the header is written first
+		{
+			data = (char *) &frame->header + frame->written;
+			pending = header_size - frame->written;
+		}
+		else									// and then the message itself (the data)
+		{
+			data = (char *) frame->body + (frame->written - header_size);
+			pending = frame->size - frame->written;
+		}
+
+		size_t chunk = (conn->bufferSize < pending) ? conn->bufferSize : pending;		/* write in chunks of at most bufferSize bytes */
+		ssize_t ret = write(conn->write_fd, data, chunk);
+		if (ret == -1)
+		{
+			if (errno == EINTR)								/* if write was interrupted by a signal continue */
+				continue;
+			if (errno == EWOULDBLOCK || errno == EAGAIN)	/* if not enough write space available yet, the rest is written later */
+				return 0;
+			perror("[Error] : write -> conn_flush\n");		/* else a more serious error occured */
+			exit(EXIT_FAILURE);
+		}
+
+		frame->written += ret;
+		if (frame->written == frame->size)		// frame was written as a whole, remove it from the queue
+		{
+			conn->first = frame->next;
+			if (conn->first == NULL)
+				conn->last = NULL;
+			pool_free(frame->body);
+			pool_free(frame);
+		}
+	}
+
+	return 1;
+}
+
+int conn_has_pending_writes(Connection conn)
+{
+	return conn->first != NULL;
+}
+
+int conn_read(Connection conn, int * msgd, int * req_id, void ** message)
+{
+	while (1)
+	{
+		if (conn->got == conn->expected)		// current state is complete, move on to the next one
+		{
+			if (conn->state == READ_HEADER)
+			{
+				/* after reading the header , now we know the remaining bytes to be read for the body of mesage*/
+				conn->state = READ_BODY;
+				conn->expected = conn->header.body_size;
+				conn->got = 0;
+				conn->body = NULL;
+				if (conn->expected)
+				{
+					conn->body = pool_alloc(conn->expected);		// allocate space for the data of message (the message itself)
+				}
+			}
+
+			if (conn->state == READ_BODY && conn->got == conn->expected)		// the whole message has been read
+			{
+				*msgd = conn->header.msgd;
+				*req_id = conn->header.req_id;
+				*message = conn->body;
+				conn->state = READ_HEADER;					// get ready for the next message
+				conn->body = NULL;
+				conn->expected = sizeof(conn->header);
+				conn->got = 0;
+				return CONN_MSG_READY;
+			}
+		}
+
+		void * data = (conn->state == READ_HEADER) ? (char *) &conn->header + conn->got : (char *) conn->body + conn->got;
+		size_t pending = conn->expected - conn->got;
+		size_t chunk = (conn->bufferSize < pending) ? conn->bufferSize : pending;		/* read in chunks of at most bufferSize bytes */
+		ssize_t ret = read(conn->read_fd, data, chunk);
+		if (ret == -1)
+		{
+			if (errno == EINTR)								/* if read was interrupted by a signal continue */
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)	/* if nothing yet to read, keep what was read so far for the next call */
+				return CONN_MSG_PARTIAL;
+			perror("[Error] : read -> conn_read\n");		/* else a more serious error occured */
+			exit(EXIT_FAILURE);
+		}
+		if (ret == 0)		// no writers left on the pipe
+			return CONN_EOF;
+
+		conn->got += ret;
+	}
+}
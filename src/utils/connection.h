@@ -0,0 +1,25 @@
+/* file : connection.h */
+/* a non blocking connection to a peer process over a pair of pipes, with a buffered write queue and a partial read state machine */
+/* messages are framed exactly as in messages.c (header first, then the body), so the peer can still use send_message/read_message */
+#pragma once
+
+typedef struct connection * Connection;
+
+/* return values of conn_read */
+#define CONN_MSG_READY 1		// a whole message has been read
+#define CONN_MSG_PARTIAL 0		// the message read so far is incomplete, and no more data is available yet
+#define CONN_EOF -1				// the peer closed its write end
+
+/* creates a connection over the given (non blocking) read and write file descriptors, that reads/writes in chunks of at most bufferSize bytes */
+Connection conn_create(int read_fd, int write_fd, int bufferSize);
+/* destroys the connection, any queued messages that have not been written are discarded (file descriptors are not closed) */
+void conn_destroy(Connection conn);
+/* queues a message with given request id to be written to the peer, the message is freed once it has been written */
+void conn_send(Connection conn, int msgd, int req_id, void * message);
+/* writes as much of the write queue as possible without blocking, returns 1 if the queue got empty, 0 otherwise */
+int conn_flush(Connection conn);
+/* returns 1 if there are queued bytes not yet written to the peer, 0 otherwise */
+int conn_has_pending_writes(Connection conn);
+/* reads as much of the current message as possible without blocking, returns CONN_MSG_READY and the message in msgd/req_id/message */
+/* once the whole message has been read, otherwise CONN_MSG_PARTIAL or CONN_EOF. Returned messages are deleted with delete_message */
+int conn_read(Connection conn, int * msgd, int * req_id, void ** message);
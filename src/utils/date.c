@@ -2,145 +2,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "date.h"
 
 // utility functions for dates
 
-// checking for validity of a date
-int date_check(char * date)
+// parses the number of up to max_digits digits at *str, moves *str after it, returns -1 if there are no digits or too many
+static int parse_number(char ** str, int max_digits)
 {
-	char * day, * month, * year;
-	char temp_date[12];
-	strcpy(temp_date, date);
-
-	char *str = strtok(temp_date, "-");
-	int i = 1;
-	while(str != NULL)
-	{
-		switch (i)
-	    {
-	    	case 1: day = str; break;
-	        case 2: month = str; break;
-	        case 3: year = str; break;
-	    }
-	    i++;
-	    str = strtok(NULL, "-");
-	}
-
-	if (i != 4)
-		return 0;
-	if (strlen(day) > 2 || strlen(month) > 2 || strlen(year) != 4)
-		return 0;
-	for (int i = 0; i < strlen(day); i++)
-	{
-		if (day[i] < '0' || day[i] > '9')
-			return 0;
-	}
-	for (int i = 0; i < strlen(month); i++)
-	{
-		if (month[i] < '0' || month[i] > '9')
-			return 0;
-	}
-
-	for (int i = 0; i < strlen(year); i++)
+	int value = 0, digits = 0;
+	for (; **str >= '0' && **str <= '9'; (*str)++)
 	{
-		if (year[i] < '0' || year[i] > '9')
-			return 0;
+		if (++digits > max_digits)
+			return -1;
+		value = value * 10 + (**str - '0');
 	}
-
-	if (atoi(day) < 1 || atoi(day) > 30 || atoi(month) < 1 || atoi(month) > 12 )
-		return 0;
-
-	return 1;
+	return (digits > 0) ? value : -1;
 }
 
-// comparing two valid dates
-int date_cmp(char * date1, char * date2)
+unsigned int date_parse(char * date)
 {
-	int day1, month1, year1;
-	int day2, month2, year2;
+	int day, month, year;
 
-	char temp_date1[12];
-	strcpy(temp_date1, date1);
-	char temp_date2[12];
-	strcpy(temp_date2, date2);
-	
+	// a date is day-month-year, with a day and a month of up to 2 digits and a year of exactly 4
+	if ((day = parse_number(&date, 2)) < 0 || *date++ != '-')
+		return DATE_NONE;
+	if ((month = parse_number(&date, 2)) < 0 || *date++ != '-')
+		return DATE_NONE;
+	char * year_digits = date;
+	if ((year = parse_number(&date, 4)) < 0 || date - year_digits != 4 || *date != '\0')
+		return DATE_NONE;
 
-	char *str1 = strtok(temp_date1, "-");
-	int i = 1;
-	while(str1 != NULL)
-	{
-		switch (i)
-	    {
-	    	case 1: day1 = atoi(str1); break;
-	        case 2: month1 = atoi(str1); break;
-	        case 3: year1 = atoi(str1); break;
-	    }
-	    i++;
-	    str1 = strtok(NULL, "-");
-	}
+	if (day < 1 || day > DATE_MONTH_DAYS || month < 1 || month > 12)
+		return DATE_NONE;
 
-	char *str2 = strtok(temp_date2, "-");
-	i = 1;
-	while(str2 != NULL)
-	{
-		switch (i)
-	    {
-	    	case 1: day2 = atoi(str2); break;
-	        case 2: month2 = atoi(str2); break;
-	        case 3: year2 = atoi(str2); break;
-	    }
-	    i++;
-	    str2 = strtok(NULL, "-");
-	}
+	return (year * 12 + month - 1) * DATE_MONTH_DAYS + day;
+}
 
-	if (year2 > year1) return -1;
-	else if (year2 < year1) return 1;
-	else if (month2 > month1) return -1;
-	else if (month2 < month1) return 1;
-	else if (day2 > day1) return -1;
-	else if (day2 < day1) return 1;
-	else return 0;
+void date_format(unsigned int day, char * date)
+{
+	unsigned int months = (day - 1) / DATE_MONTH_DAYS;
+	snprintf(date, DATE_STRING_SIZE, "%u-%u-%04u", (day - 1) % DATE_MONTH_DAYS + 1, months % 12 + 1, (months / 12) % 10000);		// years have 4 digits
 }
 
-int date_half_year_check(char * date1, char * date2)
+int date_half_year_check(unsigned int date1, unsigned int date2)
 {
-	if (date_cmp(date1, date2) > 0) 		// make sure date1 <= date2 otherwise the half year check obviously fails
+	if (date1 > date2) 		// make sure date1 <= date2 otherwise the half year check obviously fails
 		return -1;
 
-	int day1, month1, year1;
-
-	char temp_date1[12];
-	strcpy(temp_date1, date1);
-	
-
-	char *str1 = strtok(temp_date1, "-");
-	int i = 1;
-	while(str1 != NULL)
-	{
-		switch (i)
-	    {
-	    	case 1: day1 = atoi(str1); break;
-	        case 2: month1 = atoi(str1); break;
-	        case 3: year1 = atoi(str1); break;
-	    }
-	    i++;
-	    str1 = strtok(NULL, "-");
-	}
-
 	/* date1 is within to 6 months prior of date2, if and only if (date1 + 6 months) >= date2 */
-	if (month1 <= 6)
-		month1 += 6;
-	else
-	{
-		month1 = (month1 + 6) % 12;
-		year1 += 1;
-	}
-
-	char new_date1[12];
-	sprintf(new_date1, "%d-%d-%d", day1, month1, year1);
-
-	if (date_cmp(new_date1, date2) >= 0)
-		return 1;
-	else
-		return 0;	
-}
\ No newline at end of file
+	return date1 + DATE_HALF_YEAR >= date2;
+}
@@ -1,11 +1,20 @@
 /* file : date.h */
 #pragma once
 
-// checking for validity of a date
-int date_check(char * date);
-// comparing two valid dates (returns 1 if date1 > date2, 0 if equal, -1 if date1 < date2)
-int date_cmp(char * date1, char * date2);
-// checks if date1 is within a 6-month interval prior to date2
+/* dates are parsed once (day-month-year) into day numbers, that are used everywhere instead of the strings : the number of the */
+/* day counted from the start of year 0, in a calendar of 12 months of DATE_MONTH_DAYS days (a valid date has a day up to 30), */
+/* so that dates are compared as integers, and the date 6 months after a date is always DATE_HALF_YEAR days after it */
+
+#define DATE_MONTH_DAYS 30
+#define DATE_HALF_YEAR (6 * DATE_MONTH_DAYS)
+#define DATE_NONE 0				// no date (every valid date has a day number greater than it)
+#define DATE_STRING_SIZE 12		// max size of a date as a string, with the '\0'
+
+// parses a date, returns its day number, or DATE_NONE if it is not a valid date
+unsigned int date_parse(char * date);
+// writes the date of given day number into date (of DATE_STRING_SIZE bytes)
+void date_format(unsigned int day, char * date);
+// checks if date1 is within a 6-month interval prior to date2 (both day numbers)
 // assumes date1 <= date2
 // if date1 > date2 returns -1 as an error
-int date_half_year_check(char * date1, char * date2);
\ No newline at end of file
+int date_half_year_check(unsigned int date1, unsigned int date2);
@@ -4,18 +4,50 @@
 #include <string.h>
 #include <stdbool.h>
 #include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
 #include "input_check.h"
 #include "tm_helper.h"
+#include "messages.h"
 
 /* checks for correct input args from terminal and initializes program parameters if so */
-bool check_init_args(int argc, const char ** argv, int * numMonitors, int * bufferSize, unsigned int * bloom_size, DIR ** dir)
+bool check_init_args(int argc, const char ** argv, int * numMonitors, int * bufferSize, unsigned int * bloom_size, unsigned int * options, unsigned int * threads, DIR ** dir)
 {
-	if (argc != 9)
+	if (argc < 9)
 	{
-		fprintf(stderr, "Error: wrong number of args\nUse: ./travelMonitor -m numMonitors -b bufferSize -s sizeOfBloom -i input_dir\n");
+		fprintf(stderr, "Error: wrong number of args\nUse: ./travelMonitor -m numMonitors -b bufferSize -s sizeOfBloom -i input_dir [-shm] [-blocked] [-counting] [-xor] [-threads N]\n");
 		return false;
 	}
 
+	*options = 0;
+	*threads = 1;
+	for (int i = 9; i < argc; i++)		// optional flags
+	{
+		if (!strcmp(argv[i], "-shm"))
+			*options |= OPTION_SHARED_BLOOM;		// Monitors share their bloom filters through shared memory
+		else if (!strcmp(argv[i], "-blocked"))
+			*options |= OPTION_BLOCKED_BLOOM;		// bloom filters are blocked, one cache line per lookup
+		else if (!strcmp(argv[i], "-counting"))
+			*options |= OPTION_COUNTING_BLOOM;		// Monitors keep counting bloom filters, records can be corrected
+		else if (!strcmp(argv[i], "-xor"))
+			*options |= OPTION_XOR_FILTER;			// Monitors send xor filters, instead of bloom filters
+		else if (!strcmp(argv[i], "-threads"))		// Monitors read their files with N threads
+		{
+			if (i + 1 == argc || !is_integer(argv[i + 1]) || !atoi(argv[i + 1]))
+			{
+				fprintf(stderr, "Error: invalid option -threads\n Use : -threads N --> positive integer\n");
+				return false;
+			}
+			*threads = atoi(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "Error: unknown option %s\n Use : -shm -blocked -counting -xor -threads N\n", argv[i]);
+			return false;
+		}
+	}
+
 	if (strcmp(argv[1], "-m") != 0 || strcmp(argv[3], "-b") != 0 || strcmp(argv[5], "-s") != 0 || strcmp(argv[7], "-i") != 0)
 	{
 		fprintf(stderr, "Error: one or more wrong input parameters\n Use : -m -b -s -i\n");
@@ -72,7 +104,7 @@ bool is_integer(const char * string)
 
 bool check_cmd_args(struct travelMonitor * travelMonitor, char * input, const char * input_dir_name)
 {	
-	char * citizenID , * date, * countryFrom, * countryTo, * virusName, * date1, * date2, * country;
+	char * citizenID , * date, * countryFrom, * countryTo, * virusName, * date1, * date2, * country, * file_name;
 	if (!strcmp(input, "/exit"))
 	{
 		exit_travelMonitor(travelMonitor);
@@ -104,6 +136,25 @@ bool check_cmd_args(struct travelMonitor * travelMonitor, char * input, const ch
 	      	else
 	      		travelRequest(travelMonitor, citizenID, date, countryFrom, countryTo, virusName);
 	    }
+	    else if (!strcmp(str, "/travelRequestBatch"))
+	    {
+	      	int i = 0;
+	      	while(str != NULL)
+	      	{
+	         	switch (i)
+	         	{
+	         		case 1: file_name = str; break;
+	         	}
+
+	         	i++;
+	         	str = strtok(NULL, " ");
+	      	}
+
+	      	if (i != 2)
+	      		printf("Error : unknown or invalid command\n\n");
+	      	else
+	      		travelRequestBatch(travelMonitor, file_name);
+	    }
 	    else if (!strcmp(str, "/travelStats"))
 	    {
 	      	int i = 0;
@@ -171,3 +222,49 @@ bool check_cmd_args(struct travelMonitor * travelMonitor, char * input, const ch
 
 	return false;  // if command was not /exit, continue receiving commands from cmd line
 }
+
+static char cmd_buffer[4096];		// input read from stdin, that has not been returned by read_command yet
+static size_t cmd_start = 0;		// start of the input not returned yet
+static size_t cmd_end = 0;			// end of the input read so far
+static bool cmd_eof = false;		// true if stdin reached EOF
+
+char * read_command(char * input, int size)
+{
+	while (1)
+	{
+		size_t available = cmd_end - cmd_start;
+		char * newline = memchr(cmd_buffer + cmd_start, '\n', available);
+		if (newline != NULL || available >= size - 1 || (cmd_eof && available))		// a whole line (or as much of it as fits) is available
+		{
+			size_t length = (newline != NULL) ? newline - (cmd_buffer + cmd_start) + 1 : available;
+			if (length > size - 1)
+				length = size - 1;
+			memcpy(input, cmd_buffer + cmd_start, length);
+			input[length] = '\0';
+			cmd_start += length;
+			return input;
+		}
+		if (cmd_eof)
+			return NULL;
+
+		memmove(cmd_buffer, cmd_buffer + cmd_start, available);		// make room for more input
+		cmd_start = 0;
+		cmd_end = available;
+
+		ssize_t ret = read(0, cmd_buffer + cmd_end, sizeof(cmd_buffer) - cmd_end);
+		if (ret < 0)		// errno is EINTR if read was interrupted by a signal
+			return NULL;
+		if (ret == 0)
+			cmd_eof = true;
+		cmd_end += ret;
+	}
+}
+
+bool command_ready(void)
+{
+	if (memchr(cmd_buffer + cmd_start, '\n', cmd_end - cmd_start) != NULL)		// a whole command is buffered already
+		return true;
+
+	struct pollfd stdin_fd = { 0, POLLIN, 0 };
+	return !cmd_eof && poll(&stdin_fd, 1, 0) > 0;		// or stdin has more input, without waiting on it
+}
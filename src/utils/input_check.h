@@ -5,9 +5,17 @@
 #include "tm_helper.h"
 
 /* checks for correct input args from terminal and initializes program parameters if so */
-bool check_init_args(int argc, const char ** argv, int * numMonitors, int * bufferSize, unsigned int * bloom_size, DIR ** dir);
+/* after the required args, optional flags may follow, that set the options of the bloom filters (see messages.h) */
+/* and the number of threads each Monitor reads its files with (-threads N, 1 by default) */
+bool check_init_args(int argc, const char ** argv, int * numMonitors, int * bufferSize, unsigned int * bloom_size, unsigned int * options, unsigned int * threads, DIR ** dir);
 /* checks if given string, is a string of just numbers (integer) */
 bool is_integer(const char * string);
 /* checks if given input string, corresponds to a valid query, and if so, takes the necessary actions to answer to that query */
 /* returns true if command /exit was given otherwise returns false */
-bool check_cmd_args(struct travelMonitor * travelMonitor, char * input, const char * input_dir_name);
\ No newline at end of file
+bool check_cmd_args(struct travelMonitor * travelMonitor, char * input, const char * input_dir_name);
+/* reads the next command line from stdin into input, like fgets (at most size-1 chars, the newline is kept), returns NULL on EOF */
+/* or if interrupted by a signal (errno is EINTR then). Commands are read through a buffer of its own and not stdio, so that */
+/* command_ready can tell whether more commands are already waiting (e.g. when the commands come from a file or a pipe) */
+char * read_command(char * input, int size);
+/* returns true if more input is already available in stdin, so that read_command will not have to wait on the user */
+bool command_ready(void);
@@ -5,8 +5,11 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <poll.h>
 #include "messages.h"
 #include "bloom.h"
+#include "xor_filter.h"
+#include "pool.h"
 
 static unsigned int bloomSize;
 void bloomSize_init(unsigned int bloom_size)
@@ -14,20 +17,18 @@ void bloomSize_init(unsigned int bloom_size)
 	bloomSize = bloom_size;
 }
 
-void * create_msg0(int bufferSize, unsigned int bloom_size)
+void * create_msg0(int bufferSize, unsigned int bloom_size, unsigned int options, unsigned int hashes, unsigned int threads)
 {
-	void * message = calloc(1, MSG0_SIZE);
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : create_msg0 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_calloc(MSG0_SIZE);
 	memcpy(message, &bufferSize, sizeof(int));
 	memcpy(message + sizeof(int), &bloom_size, sizeof(unsigned int));
+	memcpy(message + sizeof(int) + sizeof(unsigned int), &options, sizeof(unsigned int));
+	memcpy(message + sizeof(int) + 2 * sizeof(unsigned int), &hashes, sizeof(unsigned int));
+	memcpy(message + sizeof(int) + 3 * sizeof(unsigned int), &threads, sizeof(unsigned int));
 	return message;
 }
 
-int decode_msg0(int msgd, void * message, int * bufferSize, unsigned int * bloom_size)
+int decode_msg0(int msgd, void * message, int * bufferSize, unsigned int * bloom_size, unsigned int * options, unsigned int * hashes, unsigned int * threads)
 {
 	if (msgd != MSG0)
 	{
@@ -36,18 +37,16 @@ int decode_msg0(int msgd, void * message, int * bufferSize, unsigned int * bloom
 	}
 	memcpy(bufferSize, message, sizeof(int));
 	memcpy(bloom_size, message + sizeof(int), sizeof(unsigned int));
+	memcpy(options, message + sizeof(int) + sizeof(unsigned int), sizeof(unsigned int));
+	memcpy(hashes, message + sizeof(int) + 2 * sizeof(unsigned int), sizeof(unsigned int));
+	memcpy(threads, message + sizeof(int) + 3 * sizeof(unsigned int), sizeof(unsigned int));
 	return 0;
 }
 
 
 void * create_msg1(const char * input_dir_name, char * subdir_name)
 {
-	void * message = calloc(1, MSG1_SIZE);
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : create_msg1 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_calloc(MSG1_SIZE);
 	snprintf(message, MSG1_SIZE, "%s/%s", input_dir_name, subdir_name);
 	return message;
 }
@@ -63,23 +62,140 @@ int decode_msg1(int msgd, void * message, char * subdir)
 	return 0;
 }
 
-void * create_msg2(char * virus_name, unsigned int bloom_size, Bloom bloom_filter)
+/* numbers in encoded bit arrays are varints, 7 bits per byte starting from the low ones, the high bit is set if more bytes follow */
+static size_t varint_size(unsigned int n)
 {
-	void * message = calloc(1, MSG2_SIZE + bloom_size * sizeof(uint8_t));
-	if (message == NULL)
+	size_t size = 1;
+	while (n >= 0x80)
 	{
-		fprintf(stderr, "[Error] : create_msg2 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
+		n >>= 7;
+		size++;
+	}
+	return size;
+}
+
+static uint8_t * varint_put(uint8_t * p, unsigned int n)
+{
+	while (n >= 0x80)
+	{
+		*p++ = (n & 0x7f) | 0x80;
+		n >>= 7;
+	}
+	*p++ = n;
+	return p;
+}
+
+// returns NULL if the varint does not end before end
+static uint8_t * varint_get(uint8_t * p, uint8_t * end, unsigned int * n)
+{
+	*n = 0;
+	for (int shift = 0; p < end && shift < 32; shift += 7)
+	{
+		*n |= (unsigned int) (*p & 0x7f) << shift;
+		if (!(*p++ & 0x80))
+			return p;
+	}
+	return NULL;
+}
+
+// finds the smallest encoding of given bit array (see messages.h), returns it and its size in length
+static unsigned int choose_encoding(uint8_t * bit_array, unsigned int bloom_size, unsigned int * length)
+{
+	size_t zero_runs = 0, positions = 0;
+	unsigned int zeros = 0, last_pos = 0;
+	for (unsigned int i = 0; i < bloom_size; )
+	{
+		if (bit_array[i] == 0)
+		{
+			zeros++;
+			i++;
+			continue;
+		}
+		unsigned int n = 0;		// non zero bytes starting from i
+		for (; i + n < bloom_size && bit_array[i + n] != 0; n++)
+			for (unsigned int byte = bit_array[i + n]; byte != 0; byte &= byte - 1)	// for each bit set in byte
+			{
+				unsigned int pos = (i + n) * 8 + __builtin_ctz(byte);
+				positions += varint_size(pos - last_pos);
+				last_pos = pos;
+			}
+		zero_runs += varint_size(zeros) + varint_size(n) + n;
+		zeros = 0;
+		i += n;
+	}
+
+	*length = bloom_size;
+	unsigned int encoding = MSG2_RAW;
+	if (zero_runs < *length)
+	{
+		*length = zero_runs;
+		encoding = MSG2_ZERO_RUNS;
+	}
+	if (positions < *length)
+	{
+		*length = positions;
+		encoding = MSG2_POSITIONS;
 	}
-	int count = 0;
-	for (unsigned int i = 0; i < bloom_size; i++)
-		count += bloom_filter->bit_array[i];
+	return encoding;
+}
+
+size_t msg2_size(unsigned int bloom_size, Bloom bloom_filter)
+{
+	unsigned int length;
+	choose_encoding(bloom_filter->bit_array, bloom_size, &length);
+	return MSG2_SIZE + length;
+}
+
+void * create_msg2(char * virus_name, unsigned int bloom_size, Bloom bloom_filter)
+{
+	unsigned int length;
+	unsigned int encoding = choose_encoding(bloom_filter->bit_array, bloom_size, &length);
+	void * message = pool_calloc(MSG2_SIZE + length);
 	strncpy(message, virus_name, 20);
-	memcpy(message + 20, bloom_filter->bit_array, bloom_size * sizeof(uint8_t));
+	memcpy(message + 20, &encoding, sizeof(unsigned int));
+	memcpy(message + 20 + sizeof(unsigned int), &length, sizeof(unsigned int));
+
+	uint8_t * bit_array = bloom_filter->bit_array;
+	uint8_t * p = message + MSG2_SIZE;
+	if (encoding == MSG2_RAW)
+		memcpy(p, bit_array, bloom_size * sizeof(uint8_t));
+	else if (encoding == MSG2_ZERO_RUNS)
+	{
+		unsigned int zeros = 0;
+		for (unsigned int i = 0; i < bloom_size; )
+		{
+			if (bit_array[i] == 0)
+			{
+				zeros++;
+				i++;
+				continue;
+			}
+			unsigned int n = 0;
+			while (i + n < bloom_size && bit_array[i + n] != 0)
+				n++;
+			p = varint_put(p, zeros);
+			p = varint_put(p, n);
+			memcpy(p, bit_array + i, n);
+			p += n;
+			zeros = 0;
+			i += n;
+		}
+	}
+	else
+	{
+		unsigned int last_pos = 0;
+		for (unsigned int i = 0; i < bloom_size; i++)
+			for (unsigned int byte = bit_array[i]; byte != 0; byte &= byte - 1)
+			{
+				unsigned int pos = i * 8 + __builtin_ctz(byte);
+				p = varint_put(p, pos - last_pos);
+				last_pos = pos;
+			}
+	}
 	return message;
 }
 
-int decode_msg2(int msgd, void * message, char * virus, void ** bit_array)
+int decode_msg2(int msgd, void * message, char * virus)
 {
 	if (msgd != MSG2)	// check if msgd was the one expected
 	{
@@ -87,18 +203,56 @@ int decode_msg2(int msgd, void * message, char * virus, void ** bit_array)
 		return -1;
 	}
 	strncpy(virus, message, 20);
-	*bit_array = message + 20;
 	return 0;
 }
 
-void * create_msg3(char * citizenID, char * virusName)
+int get_msg2_bit_array(void * message, void * bit_array)
 {
-	void * message = calloc(1, MSG3_SIZE);
-	if (message == NULL)
+	unsigned int encoding, length;
+	memcpy(&encoding, message + 20, sizeof(unsigned int));
+	memcpy(&length, message + 20 + sizeof(unsigned int), sizeof(unsigned int));
+	uint8_t * p = message + MSG2_SIZE, * end = p + length;
+	uint8_t * bits = bit_array;
+
+	if (encoding == MSG2_RAW)
 	{
-		fprintf(stderr, "[Error] : create_msg3 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
+		if (length != bloomSize)
+			return -1;
+		memcpy(bits, p, bloomSize * sizeof(uint8_t));
+		return 0;
 	}
+
+	memset(bits, 0, bloomSize * sizeof(uint8_t));		// only the non zero bytes/bits set are in the message
+	unsigned int i = 0, zeros, n;
+	while (p < end)
+	{
+		if (encoding == MSG2_ZERO_RUNS)
+		{
+			if ((p = varint_get(p, end, &zeros)) == NULL || (p = varint_get(p, end, &n)) == NULL)
+				return -1;
+			if ((size_t) i + zeros + n > bloomSize || n > end - p)
+				return -1;
+			i += zeros;
+			memcpy(bits + i, p, n);
+			i += n;
+			p += n;
+		}
+		else if (encoding == MSG2_POSITIONS)
+		{
+			if ((p = varint_get(p, end, &n)) == NULL || (size_t) i + n >= (size_t) bloomSize * 8)
+				return -1;
+			i += n;		// i is the position of the last bit set
+			bits[i / 8] |= 1 << (i % 8);
+		}
+		else
+			return -1;
+	}
+	return 0;
+}
+
+void * create_msg3(char * citizenID, char * virusName)
+{
+	void * message = pool_calloc(MSG3_SIZE);
 	strncpy(message, citizenID, 6);
 	strncpy(message + 6, virusName, 20);
 	return message;
@@ -116,21 +270,16 @@ int decode_msg3(int msgd, void * message, char * citizenID, char * virus)
 	return 0;
 }
 
-void * create_msg4(char * answer, char * date)
+void * create_msg4(char * answer, unsigned int date)
 {
-	void * message = calloc(1, MSG4_SIZE);
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : create_msg4 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_calloc(MSG4_SIZE);
 	strncpy(message, answer, 4);
 	if (!strcmp(answer, "YES"))
-		strncpy(message + 4, date, 12);
+		memcpy(message + 4, &date, sizeof(unsigned int));
 	return message;
 }
 
-int decode_msg4(int msgd, void * message, char * answer, char * date)
+int decode_msg4(int msgd, void * message, char * answer, unsigned int * date)
 {
 	if (msgd != MSG4)		// check if msgd was the one expected
 	{
@@ -138,18 +287,13 @@ int decode_msg4(int msgd, void * message, char * answer, char * date)
 		return -1;
 	}
 	strncpy(answer, message, 4);
-	strncpy(date, message + 4, 12);
+	memcpy(date, message + 4, sizeof(unsigned int));
 	return 0;
 }
 
 void * create_msg5(char * citizenID)
 {
-	void * message = calloc(1, MSG5_SIZE);
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : create_msg5 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_calloc(MSG5_SIZE);
 	strncpy(message, citizenID, MSG5_SIZE);
 	return message;
 }
@@ -167,12 +311,7 @@ int decode_msg5(int msgd, void * message, char * citizenID)
 
 void * create_msg6(char * name, char * surname, char * country, int age)
 {
-	void * message = calloc(1, MSG6_SIZE);
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : create_msg6 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_calloc(MSG6_SIZE);
 	strncpy(message, name, 13);
 	strncpy(message + 13, surname, 13);
 	strncpy(message + 26, country, 30);
@@ -194,22 +333,17 @@ int decode_msg6(int msgd, void * message, char * name, char * surname, char * co
 	return 0;
 }
 
-void * create_msg7(char * virusName, char * status, char * date)
+void * create_msg7(char * virusName, char * status, unsigned int date)
 {
-	void * message = calloc(1, MSG7_SIZE);
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : create_msg7 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_calloc(MSG7_SIZE);
 	strncpy(message, virusName, 20);
 	strncpy(message + 20, status, 4);
 	if (!strcmp(status, "YES"))
-		strncpy(message + 24, date, 12);
+		memcpy(message + 24, &date, sizeof(unsigned int));
 	return message;
 }
 
-int decode_msg7(int msgd, void * message, char * virus, char * status, char * date)
+int decode_msg7(int msgd, void * message, char * virus, char * status, unsigned int * date)
 {
 	if (msgd != MSG7)
 	{
@@ -218,18 +352,13 @@ int decode_msg7(int msgd, void * message, char * virus, char * status, char * da
 	}
 	strncpy(virus, message, 20);
 	strncpy(status, message + 20, 4);
-	strncpy(date, message + 24, 12);
+	memcpy(date, message + 24, sizeof(unsigned int));
 	return 0;
 }
 
 void * create_msg8(int result)
 {
-	void * message = calloc(1, MSG8_SIZE);
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : create_msg8 -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_calloc(MSG8_SIZE);
 	memcpy(message, &result, sizeof(int));
 	return message;
 }
@@ -245,41 +374,254 @@ int decode_msg8(int msgd, void * message, int * result)
 	return 0;
 }
 
+void * create_msg10(int count)
+{
+	void * message = pool_calloc(MSG10_SIZE(count));
+	memcpy(message, &count, sizeof(int));
+	return message;
+}
 
-void send_message(int write_fd, int msgd, void * message, int bufferSize)
+void set_msg10_query(void * message, int i, char * citizenID, char * virusName)
 {
-	size_t body_size;						// size of the body of the message (the actual data)
-	int * header = calloc(1, sizeof(int));	// allocate space for the header
-	if (header == NULL)
+	void * query = message + MSG10_SIZE(i);		// the i-th query starts right after the i queries before it
+	strncpy(query, citizenID, 6);
+	strncpy(query + 6, virusName, 20);
+}
+
+int decode_msg10(int msgd, void * message, int * count)
+{
+	if (msgd != MSG10)		// check if msgd was the one expected
 	{
-		fprintf(stderr, "[Error] : send_message -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
+		fprintf(stderr, "[Error] : decode_msg10 -> Unexpected message descriptor\n\n");
+		return -1;
+	}
+	memcpy(count, message, sizeof(int));
+	return 0;
+}
+
+void get_msg10_query(void * message, int i, char * citizenID, char * virus)
+{
+	void * query = message + MSG10_SIZE(i);
+	strncpy(citizenID, query, 6);
+	strncpy(virus, query + 6, 20);
+}
+
+void * create_msg11(int count)
+{
+	void * message = pool_calloc(MSG11_SIZE(count));
+	memcpy(message, &count, sizeof(int));
+	return message;
+}
+
+void set_msg11_answer(void * message, int i, char * answer, unsigned int date)
+{
+	void * reply = message + MSG11_SIZE(i);		// the i-th answer starts right after the i answers before it
+	strncpy(reply, answer, 4);
+	if (!strcmp(answer, "YES"))
+		memcpy(reply + 4, &date, sizeof(unsigned int));
+}
+
+int decode_msg11(int msgd, void * message, int * count)
+{
+	if (msgd != MSG11)		// check if msgd was the one expected
+	{
+		fprintf(stderr, "[Error] : decode_msg11 -> Unexpected message descriptor\n\n");
+		return -1;
+	}
+	memcpy(count, message, sizeof(int));
+	return 0;
+}
+
+void get_msg11_answer(void * message, int i, char * answer, unsigned int * date)
+{
+	void * reply = message + MSG11_SIZE(i);
+	strncpy(answer, reply, 4);
+	memcpy(date, reply + 4, sizeof(unsigned int));
+}
+
+void * create_msg12(int accepted, int rejected)
+{
+	void * message = pool_calloc(MSG12_SIZE);
+	memcpy(message, &accepted, sizeof(int));
+	memcpy(message + sizeof(int), &rejected, sizeof(int));
+	return message;
+}
+
+int decode_msg12(int msgd, void * message, int * accepted, int * rejected)
+{
+	if (msgd != MSG12)
+	{
+		fprintf(stderr, "[Error] : decode_msg12 -> Unexpected message descriptor\n\n");
+		return -1;
+	}
+	memcpy(accepted, message, sizeof(int));
+	memcpy(rejected, message + sizeof(int), sizeof(int));
+	return 0;
+}
+
+void * create_msg13(char * virus_name, int shm_fd, unsigned int generation)
+{
+	void * message = pool_calloc(MSG13_SIZE);
+	strncpy(message, virus_name, 20);
+	memcpy(message + 20, &shm_fd, sizeof(int));
+	memcpy(message + 20 + sizeof(int), &generation, sizeof(unsigned int));
+	return message;
+}
+
+int decode_msg13(int msgd, void * message, char * virus, int * shm_fd, unsigned int * generation)
+{
+	if (msgd != MSG13)	// check if msgd was the one expected
+	{
+		fprintf(stderr, "[Error] : decode_msg13 -> Unexpected message descriptor\n\n");
+		return -1;
 	}
+	strncpy(virus, message, 20);
+	memcpy(shm_fd, message + 20, sizeof(int));
+	memcpy(generation, message + 20 + sizeof(int), sizeof(unsigned int));
+	return 0;
+}
+
 
-	*header = msgd;
-	size_t header_size = sizeof(*header);	// size of the header of the message (the message descriptor)
-	int * tmp_header = header;
+void * create_msg14(char * virus_name, Bloom bloom_filter)
+{
+	unsigned int runs = bloom_dirty_runs(bloom_filter), words = bloom_filter->dirty_words;
+	void * message = pool_calloc(MSG14_SIZE(runs, words));
+	strncpy(message, virus_name, 20);
+	memcpy(message + 20, &runs, sizeof(unsigned int));
+	memcpy(message + 20 + sizeof(unsigned int), &words, sizeof(unsigned int));
+
+	void * run = message + MSG14_SIZE(0, 0);		// the table of runs
+	void * word = message + MSG14_SIZE(runs, 0);	// the words of the runs
+	unsigned int num_words = bloom_num_words(bloom_filter);
+	for (unsigned int first = 0; first < num_words; first++)
+	{
+		if (!bloom_word_dirty(bloom_filter, first))
+			continue;
+		unsigned int count = 1;
+		while (first + count < num_words && bloom_word_dirty(bloom_filter, first + count))		// extend the run
+			count++;
+		memcpy(run, &first, sizeof(unsigned int));
+		memcpy(run + sizeof(unsigned int), &count, sizeof(unsigned int));
+		bloom_get_words(bloom_filter, first, count, word);
+		run += 2 * sizeof(unsigned int);
+		word += count * BLOOM_WORD_SIZE;
+		first += count;
+	}
+	return message;
+}
 
+int decode_msg14(int msgd, void * message, char * virus, unsigned int * runs, void ** words)
+{
+	if (msgd != MSG14)		// check if msgd was the one expected
+	{
+		fprintf(stderr, "[Error] : decode_msg14 -> Unexpected message descriptor\n\n");
+		return -1;
+	}
+	strncpy(virus, message, 20);
+	memcpy(runs, message + 20, sizeof(unsigned int));
+	*words = message + MSG14_SIZE(*runs, 0);
+	return 0;
+}
+
+void get_msg14_run(void * message, unsigned int i, unsigned int * first_word, unsigned int * count)
+{
+	void * run = message + MSG14_SIZE(i, 0);		// the i-th run starts right after the i runs before it
+	memcpy(first_word, run, sizeof(unsigned int));
+	memcpy(count, run + sizeof(unsigned int), sizeof(unsigned int));
+}
+
+void * create_msg15(char * virus_name, XorFilter filter)
+{
+	unsigned int length = xor_filter_size(filter);
+	void * message = pool_calloc(MSG15_SIZE + length);
+	strncpy(message, virus_name, 20);
+	memcpy(message + 20, &length, sizeof(unsigned int));
+	xor_filter_write(filter, message + MSG15_SIZE);
+	return message;
+}
+
+int decode_msg15(int msgd, void * message, char * virus, unsigned int * length, void ** data)
+{
+	if (msgd != MSG15)		// check if msgd was the one expected
+	{
+		fprintf(stderr, "[Error] : decode_msg15 -> Unexpected message descriptor\n\n");
+		return -1;
+	}
+	strncpy(virus, message, 20);
+	memcpy(length, message + 20, sizeof(unsigned int));
+	*data = message + MSG15_SIZE;
+	return 0;
+}
+
+size_t message_body_size(int msgd, void * message)
+{
+	int count;
+	unsigned int runs, words, length;
 	switch (msgd)
 	{
-		case DONE : body_size = 0; break;
-		case MSG0 : body_size = MSG0_SIZE; break;
-		case MSG1 : body_size = MSG1_SIZE; break;
-		case MSG1_NO_REPLY : body_size = MSG1_SIZE; break;
-		case MSG2 : body_size = MSG2_SIZE + bloomSize * sizeof(uint8_t); break;
-		case MSG3 : body_size = MSG3_SIZE; break;
-		case MSG4 : body_size = MSG4_SIZE; break;
-		case MSG5 : body_size = MSG5_SIZE; break;
-		case MSG6 : body_size = MSG6_SIZE; break;
-		case MSG7 : body_size = MSG7_SIZE; break;
-		case MSG8 : body_size = MSG8_SIZE; break;
+		case DONE : return 0;
+		case MSG0 : return MSG0_SIZE;
+		case MSG1 : return MSG1_SIZE;
+		case MSG1_NO_REPLY : return MSG1_SIZE;
+		case MSG2 : memcpy(&length, message + 20 + sizeof(unsigned int), sizeof(unsigned int)); return MSG2_SIZE + length;	// size of the encoded bit array
+		case MSG3 : return MSG3_SIZE;
+		case MSG4 : return MSG4_SIZE;
+		case MSG5 : return MSG5_SIZE;
+		case MSG6 : return MSG6_SIZE;
+		case MSG7 : return MSG7_SIZE;
+		case MSG8 : return MSG8_SIZE;
+		case MSG10 : memcpy(&count, message, sizeof(int)); return MSG10_SIZE(count);		// batch messages start with the number of entries
+		case MSG11 : memcpy(&count, message, sizeof(int)); return MSG11_SIZE(count);
+		case MSG12 : return MSG12_SIZE;
+		case MSG13 : return MSG13_SIZE;
+		case MSG14 : memcpy(&runs, message + 20, sizeof(unsigned int)); memcpy(&words, message + 20 + sizeof(unsigned int), sizeof(unsigned int));
+					 return MSG14_SIZE(runs, words);
+		case MSG15 : memcpy(&length, message + 20, sizeof(unsigned int)); return MSG15_SIZE + length;		// size of the xor filter
 		default : fprintf(stderr, "[Error] : invalid message descriptor\n"); exit(EXIT_FAILURE);
 	}
+}
 
-	/* sending the message consists of 2 parts, the message descriptor and the body of the message */
+/* called when fd is not ready (EAGAIN) for the given poll events. The first IO_SPIN_LIMIT times it just returns, so that */
+/* the caller retries right away (the peer is usually about to make room or send data), after that it blocks in poll until fd is ready */
+static void io_wait(int fd, short events, int * spins)
+{
+	if (*spins < IO_SPIN_LIMIT)
+	{
+		*spins += 1;
+		return;
+	}
+
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = events;
+	if (poll(&pfd, 1, -1) < 0 && errno != EINTR)		/* if poll was interrupted by a signal, the caller just retries */
+	{
+		perror("[Error] : poll -> io_wait\n");
+		exit(EXIT_FAILURE);
+	}
+	*spins = 0;
+}
+
+void send_message(int write_fd, int msgd, void * message, int bufferSize)
+{
+	send_message_id(write_fd, msgd, 0, message, bufferSize);
+}
+
+void send_message_id(int write_fd, int msgd, int req_id, void * message, int bufferSize)
+{
+	size_t body_size;						// size of the body of the message (the actual data)
+	struct message_header msg_header;		// the header of the message
+	msg_header.msgd = msgd;
+	msg_header.req_id = req_id;
+	msg_header.body_size = body_size = message_body_size(msgd, message);
+	size_t header_size = sizeof(msg_header);	// size of the header of the message (the message descriptor, the request id and the size of the body)
+	char * header = (char *) &msg_header;
+
+	/* sending the message consists of 2 parts, the header and the body of the message */
 	
-	/* first we send the message descriptor */
+	/* first we send the header */
 	ssize_t ret;
+	int spins = 0;		/* times we retried without blocking (see io_wait) */
 	size_t total_pending = header_size;		/* total bytes pending to be sent */
 	while (total_pending != 0)				/* while we have not written all of them */
 	{
@@ -290,8 +632,11 @@ void send_message(int write_fd, int msgd, void * message, int bufferSize)
  			{
  				if (errno == EINTR)								/* if write was interrupted by a signal continue */
  					continue;
- 				if (errno == EWOULDBLOCK || errno == EAGAIN)	/* if not enough write space available yet just continue */
+ 				if (errno == EWOULDBLOCK || errno == EAGAIN)	/* if not enough write space available yet, wait for it */
+ 				{
+ 					io_wait(write_fd, POLLOUT, &spins);
  					continue;
+ 				}
  				perror("[Error] : write -> send_message\n");	/* else a more serious error occured */
  				exit(EXIT_FAILURE);
  			}
@@ -302,8 +647,6 @@ void send_message(int write_fd, int msgd, void * message, int bufferSize)
 		}
 	}
 
-	free(tmp_header);
-
 	if(!body_size) return;  // if there is no data in message just return
 
 	void * tmp_message = message;  // save message address to free later
@@ -319,8 +662,11 @@ void send_message(int write_fd, int msgd, void * message, int bufferSize)
  			{
  				if (errno == EINTR)							  /* if write was interrupted by a signal continue */
  					continue;
- 				if (errno == EWOULDBLOCK || errno == EAGAIN)  /* if not enough write space available yet just continue */
+ 				if (errno == EWOULDBLOCK || errno == EAGAIN)  /* if not enough write space available yet, wait for it */
+ 				{
+ 					io_wait(write_fd, POLLOUT, &spins);
  					continue;
+ 				}
  				perror("[Error] : write -> send_message\n");	/* else a more serious error occured */
  				exit(EXIT_FAILURE);
  			}
@@ -331,16 +677,24 @@ void send_message(int write_fd, int msgd, void * message, int bufferSize)
 		}
 	}
 
-	free(tmp_message);
+	pool_free(tmp_message);
 }
 
 void * read_message(int read_fd, int * msgd, int bufferSize)
 {
-	/* reading the message consists of 2 parts, reading the message descriptor and then reading the body of the message */
-	/* first we read the message descriptor of message */
-	int * header = msgd;		
+	int req_id;
+	return read_message_id(read_fd, msgd, &req_id, bufferSize);
+}
+
+void * read_message_id(int read_fd, int * msgd, int * req_id, int bufferSize)
+{
+	/* reading the message consists of 2 parts, reading the header and then reading the body of the message */
+	/* first we read the header of message */
+	struct message_header msg_header;
+	char * header = (char *) &msg_header;
 	ssize_t ret;
-	size_t total_pending = sizeof(*header);		/* total bytes pending to be read */
+	int spins = 0;		/* times we retried without blocking (see io_wait) */
+	size_t total_pending = sizeof(msg_header);		/* total bytes pending to be read */
 	size_t total = total_pending;
 	while (total_pending != 0)				/* while we have not read all of them */
 	{
@@ -353,8 +707,11 @@ void * read_message(int read_fd, int * msgd, int bufferSize)
  					return NULL;
  				if (errno == EINTR && total_pending != total)		/* if read was interrupted by a signal but you have already read part of message ignore signal for now (unsafe interrupt)*/
  					continue;
- 				if (errno == EAGAIN || errno == EWOULDBLOCK)		/* if nothing yet to read just continue */
+ 				if (errno == EAGAIN || errno == EWOULDBLOCK)		/* if nothing yet to read, wait for it */
+ 				{
+ 					io_wait(read_fd, POLLIN, &spins);
  					continue;
+ 				}
  				perror("[Error] : read -> read_message\n");		/* else a more serious error occured */
  				exit(EXIT_FAILURE);
  			}
@@ -365,37 +722,17 @@ void * read_message(int read_fd, int * msgd, int bufferSize)
 		}
 	}
 
-	/* after reading the header , now we know the message descriptor and thus the message structure and thus the remaining bytes to be read for the body of mesage*/
-	//msgd = header;
-	size_t body_size;
-	
-	switch (*msgd)
-	{
-		case DONE : body_size = 0; break;
-		case MSG0 : body_size = MSG0_SIZE; break;
-		case MSG1 : body_size = MSG1_SIZE; break;
-		case MSG1_NO_REPLY : body_size = MSG1_SIZE; break;
-		case MSG2 : body_size = MSG2_SIZE + bloomSize * sizeof(uint8_t); break;
-		case MSG3 : body_size = MSG3_SIZE; break;
-		case MSG4 : body_size = MSG4_SIZE; break;
-		case MSG5 : body_size = MSG5_SIZE; break;
-		case MSG6 : body_size = MSG6_SIZE; break;
-		case MSG7 : body_size = MSG7_SIZE; break;
-		case MSG8 : body_size = MSG8_SIZE; break;
-		default : fprintf(stderr, "[Error] : invalid message descriptor\n"); exit(EXIT_FAILURE);
-	}
+	/* after reading the header , now we know the message descriptor and the remaining bytes to be read for the body of mesage*/
+	*msgd = msg_header.msgd;
+	*req_id = msg_header.req_id;
+	size_t body_size = msg_header.body_size;
 
 
 	if(!body_size) return NULL;  // if there is no data in message just return empty data message
 
 	/* now  we are ready to read the message itself (the data) */
 	total_pending = body_size;
-	void * message = calloc(1, body_size);		// allocate space for the data of message (the message itself)
-	if (message == NULL)
-	{
-		fprintf(stderr, "[Error] : read_message -> calloc returned NULL\n\n");
-		exit(EXIT_FAILURE);
-	}
+	void * message = pool_alloc(body_size);		// allocate space for the data of message (the message itself), all of it is read below
 	void * message_buf = message;
 
 	while (total_pending != 0)				/* while we have not read all of them bytes */
@@ -405,8 +742,13 @@ void * read_message(int read_fd, int * msgd, int bufferSize)
 		{
  			if (ret == -1) 
  			{
- 				if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)	/* if read was interrupted by a signal or nothing yet to read just continue */
+ 				if (errno == EINTR)		/* if read was interrupted by a signal just continue */
+ 					continue;
+ 				if (errno == EAGAIN || errno == EWOULDBLOCK)		/* if nothing yet to read, wait for it */
+ 				{
+ 					io_wait(read_fd, POLLIN, &spins);
  					continue;
+ 				}
  				perror("[Error] : read -> read_message\n");		/* else a more serious error occured */
  				exit(EXIT_FAILURE);
  			}
@@ -422,5 +764,5 @@ void * read_message(int read_fd, int * msgd, int bufferSize)
 
 void delete_message(void * message)
 {
-	free(message);
+	pool_free(message);
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 /* file : messages.h */
 #pragma once
+#include <stddef.h>
 #include "bloom.h"
+#include "xor_filter.h"
 
 /* here we define the structure of possible messages between travelMonitor and Monitor processes */
-/* all messages have constant max size in bytes, so that the ipc is more straightforward */
+/* all messages have constant max size in bytes, so that the ipc is more straightforward, except the batch messages (MSG10, MSG11) */
+/* whose size depends on the number of requests in the batch, the delta updates of bloom filters (MSG14) and the xor filters (MSG15) */
 
 /* each message type has each own unique message descriptor msgd */
 #define DONE -1
@@ -19,30 +22,64 @@
 #define MSG1_NO_REPLY 9		// this type of message is for when the parent forks a new child to replace an old one that terminated unexpectedly
 							// in this case the parent does not expect a reply, since he already has the bloom filters saved
 							// its structure is essentially identical to that of MSG1, we just use a different message descriptor because the response changes
+#define MSG10 10
+#define MSG11 11
+#define MSG12 12
+#define MSG13 13
+#define MSG14 14
+#define MSG15 15
 
 /* message descriptors will always be the first bytes sent to indicate the type of message to expect */
 
+/* every message begins with a header, and then follows the body of the message (the data) */
+struct message_header {
+	int msgd;		// the message descriptor
+	int req_id;		// request id, a reply carries the request id of the message it answers, so that replies can be matched to their requests (0 if not used)
+	unsigned int body_size;		// size of the body in bytes, so that the reader knows how much to read even for messages of variable size
+};
+
+/* when a pipe is not ready for a read/write, send_message and read_message retry right away up to IO_SPIN_LIMIT times */
+/* and then block in poll, so that a process waiting on a slow peer does not busy-spin */
+#define IO_SPIN_LIMIT 64
+
 /* messages */
 
-/* initialization phase , travelMonitor sends the bufferSize and the bloom filter size to the Monitor process */
-/* msg0 structure : <int bufferSize> <unsigned int bloom_size> */
-#define MSG0_SIZE sizeof(int) + sizeof(unsigned int)
+/* initialization phase , travelMonitor sends the bufferSize, the bloom filter size, the options of the bloom filters, the number of */
+/* hash functions of the bloom filters and the number of threads that read the files of records (see m_ingest.h) to the Monitor process */
+/* msg0 structure : <int bufferSize> <unsigned int bloom_size> <unsigned int options> <unsigned int hashes> <unsigned int threads> */
+#define MSG0_SIZE (sizeof(int) + 4 * sizeof(unsigned int))
+
+/* options of the bloom filters (flags of msg0) */
+#define OPTION_SHARED_BLOOM 0x1		// bit arrays are kept in shared memory, that the travelMonitor maps, and msg13 is sent instead of msg2
+#define OPTION_BLOCKED_BLOOM 0x2	// bloom filters are blocked (see bloom.h), so that both processes set/check the same bits
+#define OPTION_COUNTING_BLOOM 0x4	// Monitors keep counting bloom filters, so that records can be corrected (see Monitor_insert)
+#define OPTION_XOR_FILTER 0x8		// Monitors send xor filters of the vaccinated citizens (msg15), instead of their bloom filters
 
 /* initialization phase , travelMonitor sends one subdirectory for each country to a Monitor process */
 /* msg1 structure : <char subdir[30]> */
 #define MSG1_SIZE 30
 
+/* every Monitor keeps a snapshot of its state, in the file named after the fifo it reads from plus SNAPSHOT_SUFFIX (see m_snapshot.h) */
+/* a Monitor that gets its subdirectories with MSG1_NO_REPLY (a replacement) starts from it, the travelMonitor deletes them on exit */
+#define SNAPSHOT_SUFFIX ".snapshot"
+
 /* initialization phase, a Monitor process sends back a bloom filter for each virus, among all countries it monitors */
-/* msg2 structure : <char virus[20]> <uint8_t bit_array[bloom_size]> */
-#define MSG2_SIZE 20
+/* the bit array is encoded with whichever of the encodings below is the smallest for it, and length is the size of the encoded bit array */
+/* msg2 structure : <char virus[20]> <unsigned int encoding> <unsigned int length> <uint8_t encoded_bit_array[length]> */
+#define MSG2_SIZE (20 + 2 * sizeof(unsigned int))
+
+/* encodings of the bit array of msg2, numbers are written as varints (7 bits per byte, high bit set if more bytes follow) */
+#define MSG2_RAW 0				// the bit array as is (bloom_size bytes)
+#define MSG2_ZERO_RUNS 1		// sequence of <varint zero bytes skipped> <varint n> <n non zero bytes>, the rest of the bytes are zero
+#define MSG2_POSITIONS 2		// the positions of the bits that are set, in increasing order, each one as the gap from the previous one
 
 /* query 1, travelMonitor needs to know for sure if a specific citizenID has been vaccinated for specific virus, and asks a monitor process */
 /* msg3 structure : <char citizenID[6]> <char virus[20]> */
 #define MSG3_SIZE 26
 
-/* monitor process replies to travelMonitor regarding query 1 with an answer (YES/NO) and a date of vaccination */
-/* msg4 structure : <char answer[4]> <char date[12]> */
-#define MSG4_SIZE 16
+/* monitor process replies to travelMonitor regarding query 1 with an answer (YES/NO) and a date of vaccination (a day number, see date.h) */
+/* msg4 structure : <char answer[4]> <unsigned int date> */
+#define MSG4_SIZE (4 + sizeof(unsigned int))
 
 /* query 4, travelMonitor asks each monitor process to find all they know about a specific citizen with given citizenID */
 /* msg5 structure : <char citizenID[6]> */
@@ -50,59 +87,132 @@
 
 /* monitor process replies to travelMonitor regarding query 4, with a name, surname, age and country for given citizen */
 /* msg6 structure : <char name[13]> <char surname[13]> <char country[30]> <int age> */
-#define MSG6_SIZE 56 + sizeof(int)
+#define MSG6_SIZE (56 + sizeof(int))
 
-/* monitor process replies to travelMonitor regarding query 4, with a virus and vaccine status and vaccination date */
-/* msg7 structure : <char virus[20]> <char status[4]> <char date[12]> */
-#define MSG7_SIZE 36
+/* monitor process replies to travelMonitor regarding query 4, with a virus and vaccine status and vaccination date (a day number) */
+/* msg7 structure : <char virus[20]> <char status[4]> <unsigned int date> */
+#define MSG7_SIZE (24 + sizeof(unsigned int))
 
 /* travelMonitor tells Monitor process that handles CountryTo if the request got rejected/accepted */
 /* msg8 structure : <int result>*/
 #define MSG8_SIZE sizeof(int)
 
+/* batch of query 1 (/travelRequestBatch), travelMonitor asks a monitor process about many citizenIDs/viruses at once */
+/* msg10 structure : <int count> <count times : char citizenID[6] char virus[20]> */
+#define MSG10_SIZE(count) (sizeof(int) + (count) * MSG3_SIZE)
+
+/* monitor process replies to travelMonitor regarding a batch of query 1, with an answer for each query, in the same order */
+/* msg11 structure : <int count> <count times : char answer[4] unsigned int date> */
+#define MSG11_SIZE(count) (sizeof(int) + (count) * MSG4_SIZE)
+
+/* travelMonitor tells Monitor process that handles CountryTo how many requests of a batch got accepted/rejected */
+/* msg12 structure : <int accepted> <int rejected> */
+#define MSG12_SIZE (2 * sizeof(int))
+
+/* same as msg2, when bloom filters are shared (OPTION_SHARED_BLOOM), a Monitor process sends the handle of the shared memory segment of a */
+/* bloom filter (an fd of the Monitor, that the travelMonitor opens as /proc/<pid>/fd/<shm_fd>) and its generation, instead of the bit array */
+/* msg13 structure : <char virus[20]> <int shm_fd> <unsigned int generation> */
+#define MSG13_SIZE (20 + sizeof(int) + sizeof(unsigned int))
+
+/* /addVaccinationRecords, a Monitor process sends only the words of a bloom filter that changed since it last sent it (see bloom.h), */
+/* grouped in runs of consecutive words, instead of the whole bit array (msg2), the words of all runs follow the table of runs */
+/* msg14 structure : <char virus[20]> <unsigned int runs> <unsigned int words> <runs times : unsigned int first_word unsigned int count> */
+/*                   <words times : uint64_t word> */
+#define MSG14_SIZE(runs, words) (20 + (2 + 2 * (size_t) (runs)) * sizeof(unsigned int) + (size_t) (words) * BLOOM_WORD_SIZE)
+
+/* same as msg2, when OPTION_XOR_FILTER is set, a Monitor process sends a xor filter (see xor_filter.h) of the citizens vaccinated for a virus, */
+/* built from its B+tree, each time it changed, that the travelMonitor checks instead of a bloom filter */
+/* msg15 structure : <char virus[20]> <unsigned int length> <uint8_t xor_filter[length]> */
+#define MSG15_SIZE (20 + sizeof(unsigned int))
+
 /* creates a message of type msg0 */
-void * create_msg0(int bufferSize, unsigned int bloom_size);
+void * create_msg0(int bufferSize, unsigned int bloom_size, unsigned int options, unsigned int hashes, unsigned int threads);
 /* creates a message of type msg1 */
 void * create_msg1(const char * input_dir_name, char * subdir_name);
 /* creates a message of type msg2 */
 void * create_msg2(char * virus_name, unsigned int bloom_size, Bloom bloom_filter);
+/* returns the size of the body of a message of type msg2 for given bloom filter, without creating it */
+size_t msg2_size(unsigned int bloom_size, Bloom bloom_filter);
 /* creates a message of type msg3 */
 void * create_msg3(char * citizenID, char * virusName);
 /* creates a message of type msg4 */
-void * create_msg4(char * answer, char * date);
+void * create_msg4(char * answer, unsigned int date);
 /* creates a message of type msg5 */
 void * create_msg5(char * citizenID);
 /* creates a message of type msg6 */
 void * create_msg6(char * name, char * surname, char * country, int age);
 /* creates a message of type msg7 */
-void * create_msg7(char * virusName, char * status, char * date);
+void * create_msg7(char * virusName, char * status, unsigned int date);
 /* creates a message of type msg8 */
 void * create_msg8(int result);
-
+/* creates a message of type msg10 with room for count queries, that are set with set_msg10_query */
+void * create_msg10(int count);
+/* sets the i-th query of a message of type msg10 */
+void set_msg10_query(void * message, int i, char * citizenID, char * virusName);
+/* creates a message of type msg11 with room for count answers, that are set with set_msg11_answer */
+void * create_msg11(int count);
+/* sets the i-th answer of a message of type msg11 */
+void set_msg11_answer(void * message, int i, char * answer, unsigned int date);
+/* creates a message of type msg12 */
+void * create_msg12(int accepted, int rejected);
+/* creates a message of type msg13 */
+void * create_msg13(char * virus_name, int shm_fd, unsigned int generation);
+/* creates a message of type msg14, with the words of given bloom filter that changed since the last bloom_clear_dirty */
+void * create_msg14(char * virus_name, Bloom bloom_filter);
+/* creates a message of type msg15 */
+void * create_msg15(char * virus_name, XorFilter filter);
+
+/* returns the size in bytes of the body of given message with given message descriptor */
+/* (the message itself is only looked at for messages of variable size, for the rest it may be NULL) */
+size_t message_body_size(int msgd, void * message);
 /* sends a message using the given write file descriptor, where msgd is the message descriptor id, and message is just the message */
 void send_message(int write_fd, int msgd, void * message, int bufferSize);
+/* same as send_message, but the header of the message also carries given request id */
+void send_message_id(int write_fd, int msgd, int req_id, void * message, int bufferSize);
 /* reads a message using the given read file descriptor, returns the message's message descriptor id in msgd, returns the message */
 void * read_message(int read_fd, int * msgd, int bufferSize);
+/* same as read_message, but also returns the request id carried in the header of the message */
+void * read_message_id(int read_fd, int * msgd, int * req_id, int bufferSize);
 /* deletes message (just frees allocated memory) */
 void delete_message(void * message);
 
 /* decodes and returns info of message of type msg0 */
-int decode_msg0(int msgd, void * message, int * bufferSize, unsigned int * bloom_size);
+int decode_msg0(int msgd, void * message, int * bufferSize, unsigned int * bloom_size, unsigned int * options, unsigned int * hashes, unsigned int * threads);
 /* decodes and returns info of message of type msg1 */
 int decode_msg1(int msgd, void * message, char * subdir);
-/* decodes and returns info of message of type msg2 */
-int decode_msg2(int msgd, void * message, char * virus, void ** bit_array);
+/* decodes message of type msg2, returns the virus, the bit array is then read with get_msg2_bit_array */
+int decode_msg2(int msgd, void * message, char * virus);
+/* decodes the bit array of a message of type msg2 into given bit_array (of bloom_size bytes), returns -1 if the encoding is invalid */
+int get_msg2_bit_array(void * message, void * bit_array);
 /* decodes and returns info of message of type msg3 */
 int decode_msg3(int msgd, void * message, char * citizenID, char * virus);
 /* decodes and returns info of message of type msg4 */
-int decode_msg4(int msgd, void * message, char * answer, char * date);
+int decode_msg4(int msgd, void * message, char * answer, unsigned int * date);
 /* decodes and returns info of message of type msg5 */
 int decode_msg5(int msgd, void * message, char * citizenID);
 /* decodes and returns info of message of type msg6 */
 int decode_msg6(int msgd, void * message, char * name, char * surname, char * country, int * age);
 /* decodes and returns info of message of type msg7 */
-int decode_msg7(int msgd, void * message, char * virus, char * status, char * date);
+int decode_msg7(int msgd, void * message, char * virus, char * status, unsigned int * date);
 /* decodes and returns info of message of type msg8 */
 int decode_msg8(int msgd, void * message, int * result);
+/* decodes message of type msg10, returns the number of queries in count, the queries are then read with get_msg10_query */
+int decode_msg10(int msgd, void * message, int * count);
+/* returns the i-th query of a message of type msg10 */
+void get_msg10_query(void * message, int i, char * citizenID, char * virus);
+/* decodes message of type msg11, returns the number of answers in count, the answers are then read with get_msg11_answer */
+int decode_msg11(int msgd, void * message, int * count);
+/* returns the i-th answer of a message of type msg11 */
+void get_msg11_answer(void * message, int i, char * answer, unsigned int * date);
+/* decodes and returns info of message of type msg12 */
+int decode_msg12(int msgd, void * message, int * accepted, int * rejected);
+/* decodes and returns info of message of type msg13 */
+int decode_msg13(int msgd, void * message, char * virus, int * shm_fd, unsigned int * generation);
+/* decodes message of type msg14, returns the number of runs in runs and the words of all runs in words, the runs are then read with get_msg14_run */
+int decode_msg14(int msgd, void * message, char * virus, unsigned int * runs, void ** words);
+/* returns the first word and the number of words of the i-th run of a message of type msg14 */
+void get_msg14_run(void * message, unsigned int i, unsigned int * first_word, unsigned int * count);
+/* decodes message of type msg15, returns the serialized xor filter (to be read with xor_filter_read) in data and its size in length */
+int decode_msg15(int msgd, void * message, char * virus, unsigned int * length, void ** data);
 
 void bloomSize_init(unsigned int bloom_size);
\ No newline at end of file